@@ -2,13 +2,31 @@
 #define CPP_DYN_HPP
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cassert>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <exception>
 #include <functional>
 #include <initializer_list>
+#include <memory>
 #include <meta>
+#include <mutex>
+#include <new>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace khct::detail {
 
@@ -17,12 +35,6 @@ struct overload_set : T... {
    using T::operator()...;
 };
 
-// The current implementation doesn't have this, so provide it here
-consteval auto define_static_object(const auto& obj) -> auto
-{
-   return &std::define_static_array(std::initializer_list{obj})[0];
-}
-
 // This is std::meta::annotations_of_with_type in C++26
 consteval auto annotations_of_with_type(std::meta::info class_, std::meta::info type) -> std::vector<std::meta::info>
 {
@@ -52,6 +64,29 @@ public:
    }
 
    explicit constexpr tuple(const Ts&... vals) noexcept(noexcept(impl{vals...})) : data_{vals...} {}
+
+   friend constexpr auto operator==(const tuple& lhs, const tuple& rhs) noexcept -> bool
+   {
+      template for (constexpr auto m : impl_members)
+      {
+         if (lhs.data_.[:m:] != rhs.data_.[:m:]) {
+            return false;
+         }
+      }
+      return true;
+   }
+
+   // This is a strict total order, but it's only meaningful for grouping equal tuples together
+   friend constexpr auto operator<(const tuple& lhs, const tuple& rhs) noexcept -> bool
+   {
+      template for (constexpr auto m : impl_members)
+      {
+         if (lhs.data_.[:m:] != rhs.data_.[:m:]) {
+            return std::less<>{}(lhs.data_.[:m:], rhs.data_.[:m:]);
+         }
+      }
+      return false;
+   }
 };
 
 template<typename Tuple1, typename Tuple2>
@@ -78,6 +113,9 @@ inline constexpr struct {
 inline constexpr struct {
 } auto_trait;
 
+inline constexpr struct {
+} bulk;
+
 namespace detail {
 
 template<typename T>
@@ -106,6 +144,15 @@ struct owning_dyn_options {
    /// @brief The number of bytes to store objects into.
    ///        If this is 0, dynamically allocate objects instead of locally storing them.
    std::size_t stack_size;
+   /// @brief The alignment of the local storage, ignored if stack_size is 0.
+   ///        If this is 0, alignof(std::max_align_t) is used.
+   std::size_t stack_align;
+};
+
+struct thin_owning_dyn_options {
+   /// @brief If the vtable should be stored directly in the heap block (if true)
+   ///        or if the heap block should store a pointer to it
+   bool store_vtable_inline;
 };
 
 template<typename Trait, non_owning_dyn_options Opt>
@@ -114,6 +161,12 @@ struct non_owning_dyn_trait;
 template<typename Trait, owning_dyn_options Opt>
 struct owning_dyn_trait;
 
+template<typename Trait, thin_owning_dyn_options Opt>
+struct thin_owning_dyn_trait;
+
+template<typename Trait, typename T>
+struct static_dyn;
+
 namespace detail {
 
 template<std::meta::info... Infos>
@@ -151,6 +204,25 @@ consteval auto member_func_to_non_member_func(std::meta::info f, std::meta::info
    return std::meta::substitute(std::meta::is_noexcept(f) ? ^^noexcept_func_ptr_maker : ^^func_ptr_maker, infos);
 }
 
+// Static functions don't need the object, so they are stored in the vtable directly instead of through a thunk
+consteval auto is_direct_slot(std::meta::info f) -> bool
+{
+   return std::meta::is_static_member(f) && !std::meta::is_function_template(f);
+}
+
+consteval auto vtable_slot_type(std::meta::info f, std::meta::info trait) -> std::meta::info
+{
+   if (!is_direct_slot(f)) {
+      return member_func_to_non_member_func(f, trait);
+   }
+   std::vector<std::meta::info> infos;
+   infos.push_back(std::meta::return_type_of(f));
+   for (const auto i : std::meta::parameters_of(f)) {
+      infos.push_back(std::meta::type_of(i));
+   }
+   return std::meta::substitute(std::meta::is_noexcept(f) ? ^^noexcept_func_ptr_maker : ^^func_ptr_maker, infos);
+}
+
 consteval auto get_sorted_funcs_by_name(std::meta::info c) -> std::vector<std::meta::info>
 {
    auto f = std::meta::members_of(c, std::meta::access_context::current())
@@ -166,10 +238,32 @@ consteval auto get_sorted_funcs_by_name(std::meta::info c) -> std::vector<std::m
    return f;
 }
 
+// The functions of an implementation, including the ones inherited from public bases that aren't hidden by a
+// function with the same name
+consteval auto get_impl_funcs(std::meta::info c) -> std::vector<std::meta::info>
+{
+   auto funcs = get_sorted_funcs_by_name(c);
+   const auto own_count = funcs.size();
+   for (const auto base : std::meta::bases_of(c, std::meta::access_context::current())) {
+      for (const auto f : get_impl_funcs(std::meta::type_of(base))) {
+         const auto own = std::span{funcs}.first(own_count);
+         if (std::ranges::find(own, std::meta::identifier_of(f), std::meta::identifier_of) == own.end()
+             && !std::ranges::contains(funcs, f)) {
+            funcs.push_back(f);
+         }
+      }
+   }
+   std::ranges::sort(funcs, {}, [](auto x) { return std::meta::identifier_of(x); });
+   return funcs;
+}
+
 consteval auto partition_sorted_funcs_by_name(const std::span<const std::meta::info> funcs)
    -> std::vector<std::vector<std::meta::info>>
 {
    std::vector<std::vector<std::meta::info>> to_ret;
+   if (funcs.empty()) {
+      return to_ret;
+   }
    to_ret.emplace_back();
 
    auto cur_name = std::meta::identifier_of(funcs[0]);
@@ -185,20 +279,38 @@ consteval auto partition_sorted_funcs_by_name(const std::span<const std::meta::i
    return to_ret;
 }
 
+consteval auto get_fields(std::meta::info c) -> std::vector<std::meta::info>
+{
+   return std::meta::nonstatic_data_members_of(c, std::meta::access_context::current());
+}
+
 // We don't need TraitClass, but have it to prevent passing other dyn_trait functions
 template<typename TraitClass, auto... Rest>
 struct func_caller;
 
-template<bool InlineVtable, typename Class, std::size_t I>
-constexpr auto get_vtable(auto* c) noexcept -> auto&
+// Names a data member of a trait; the vtable stores its offset within the implementation at SlotIndex
+template<typename TraitClass, typename T, std::size_t SlotIndex>
+struct field_ref {};
+
+// Selects the constructors of dyn trait structs that take an already type erased object and its vtable
+struct from_parts_tag {};
+
+template<typename Class, std::size_t I>
+constexpr auto get_vtable(const void* c) noexcept -> const auto&
 {
-   static constexpr bool is_const = std::is_const_v<std::remove_pointer_t<decltype(c)>>;
-   using cast_type = std::conditional_t<is_const, const Class*, Class*>;
-   if constexpr (InlineVtable) {
-      return static_cast<cast_type>(c)->funcs_.template get<I>();
+   return static_cast<const Class*>(c)->vtable().template get<I>();
+}
+
+template<bool PassObject, typename Slot, typename Ptr, typename... Args>
+constexpr auto invoke_slot(Slot slot, Ptr obj, Args&&... args) noexcept(
+   PassObject ? std::is_nothrow_invocable_v<Slot, Ptr, Args...> : std::is_nothrow_invocable_v<Slot, Args...>)
+   -> decltype(auto)
+{
+   if constexpr (PassObject) {
+      return slot(obj, std::forward<Args>(args)...);
    }
    else {
-      return static_cast<cast_type>(c)->funcs_->template get<I>();
+      return slot(std::forward<Args>(args)...);
    }
 }
 
@@ -211,37 +323,59 @@ struct func_caller<TraitClass, FuncIndex, IsOwning> {
    template<typename Trait, owning_dyn_options Opt>
    friend struct ::khct::owning_dyn_trait;
 
+   template<typename Trait, thin_owning_dyn_options Opt>
+   friend struct ::khct::thin_owning_dyn_trait;
+
+   template<typename Trait, typename T>
+   friend struct ::khct::static_dyn;
+
 private:
-   template<bool InlineVtable, typename Class, typename... Args>
-   static constexpr auto
-      call(const void* c, Args&&... args) noexcept(noexcept(get_vtable<InlineVtable, Class, FuncIndex + IsOwning>(c)(
-         static_cast<const Class*>(c)->data(), std::forward<Args>(args)...))) -> decltype(auto)
+   static constexpr bool pass_object = !is_direct_slot(get_sorted_funcs_by_name(^^TraitClass)[FuncIndex]);
+
+   // The index of the trait function that is called, for calls that don't go through a vtable
+   template<typename Ptr, typename... Args>
+   static constexpr std::size_t func_index = FuncIndex;
+
+   template<typename Class, typename... Args>
+   static constexpr auto call(const void* c, Args&&... args) noexcept(noexcept(invoke_slot<pass_object>(
+      get_vtable<Class, FuncIndex + IsOwning>(c),
+      static_cast<const Class*>(c)->data(),
+      std::forward<Args>(args)...))) -> decltype(auto)
    {
       const auto* const ptr = static_cast<const Class*>(c);
-      return get_vtable<InlineVtable, Class, FuncIndex + IsOwning>(c)(ptr->data(), std::forward<Args>(args)...);
+      return invoke_slot<pass_object>(
+         get_vtable<Class, FuncIndex + IsOwning>(c), ptr->data(), std::forward<Args>(args)...);
    }
 
-   template<bool InlineVtable, typename Class, typename... Args>
-   static constexpr auto
-      call(void* c, Args&&... args) noexcept(noexcept(get_vtable<InlineVtable, Class, FuncIndex + IsOwning>(c)(
-         static_cast<Class*>(c)->data(), std::forward<Args>(args)...))) -> decltype(auto)
+   template<typename Class, typename... Args>
+   static constexpr auto call(void* c, Args&&... args) noexcept(noexcept(invoke_slot<pass_object>(
+      get_vtable<Class, FuncIndex + IsOwning>(c),
+      static_cast<Class*>(c)->data(),
+      std::forward<Args>(args)...))) -> decltype(auto)
    {
       auto* const ptr = static_cast<Class*>(c);
-      return get_vtable<InlineVtable, Class, FuncIndex + IsOwning>(c)(ptr->data(), std::forward<Args>(args)...);
+      return invoke_slot<pass_object>(
+         get_vtable<Class, FuncIndex + IsOwning>(c), ptr->data(), std::forward<Args>(args)...);
    }
 };
 
-template<std::size_t Index, typename FuncType>
+template<std::size_t Index, bool PassObject>
+struct slot_ref {
+   static constexpr std::size_t value = Index;
+   static constexpr bool pass_object = PassObject;
+};
+
+template<std::size_t Index, bool PassObject, typename FuncType>
 struct func_caller_helper;
 
-template<std::size_t Index, typename RetType, typename... Args>
-struct func_caller_helper<Index, RetType (*)(Args...)> {
-   static consteval auto operator()(Args...) noexcept -> std::integral_constant<std::size_t, Index>;
+template<std::size_t Index, bool PassObject, typename RetType, typename... Args>
+struct func_caller_helper<Index, PassObject, RetType (*)(Args...)> {
+   static consteval auto operator()(Args...) noexcept -> slot_ref<Index, PassObject>;
 };
 
-template<std::size_t Index, typename RetType, typename... Args>
-struct func_caller_helper<Index, RetType (*)(Args...) noexcept> {
-   static consteval auto operator()(Args...) noexcept -> std::integral_constant<std::size_t, Index>;
+template<std::size_t Index, bool PassObject, typename RetType, typename... Args>
+struct func_caller_helper<Index, PassObject, RetType (*)(Args...) noexcept> {
+   static consteval auto operator()(Args...) noexcept -> slot_ref<Index, PassObject>;
 };
 
 // This specialization is used for overload sets with the specified name
@@ -253,6 +387,12 @@ struct func_caller<TraitClass, StartIndex, Name, IsOwning> {
    template<typename Trait, owning_dyn_options Opt>
    friend struct ::khct::owning_dyn_trait;
 
+   template<typename Trait, thin_owning_dyn_options Opt>
+   friend struct ::khct::thin_owning_dyn_trait;
+
+   template<typename Trait, typename T>
+   friend struct ::khct::static_dyn;
+
 private:
    static constexpr std::span<const std::meta::info> funcs = []() consteval -> std::span<const std::meta::info> {
       static constexpr auto funcs = std::define_static_array(get_sorted_funcs_by_name(^^TraitClass));
@@ -273,41 +413,111 @@ private:
       return []<std::size_t... I>(std::index_sequence<I...>) {
          return ::khct::detail::overload_set{func_caller_helper<
             StartIndex + I + IsOwning,
+            !is_direct_slot(funcs[I]),
             typename[:member_func_to_non_member_func(funcs[I], ^^TraitClass):]>{}...};
       }(std::make_index_sequence<funcs.size()>{});
    }();
 
-   template<bool InlineVtable, typename Class, typename... Args>
+   template<typename Ptr, typename... Args>
+   using slot_for = decltype(get_indexer(std::declval<Ptr>(), std::declval<Args>()...));
+
+   // The index of the trait function that is called, for calls that don't go through a vtable
+   template<typename Ptr, typename... Args>
+   static constexpr std::size_t func_index = slot_for<Ptr, Args...>::value - IsOwning;
+
+   template<typename Class, typename... Args>
    static constexpr auto call(const void* c, Args&&... args) noexcept(
-      noexcept(get_vtable<
-               InlineVtable,
-               Class,
-               decltype(get_indexer(std::declval<const Class*>(), std::declval<Args>()...))::value>(c)(
-         static_cast<const Class*>(c)->data(), std::forward<Args>(args)...))) -> decltype(auto)
+      noexcept(invoke_slot<slot_for<const Class*, Args...>::pass_object>(
+         get_vtable<Class, slot_for<const Class*, Args...>::value>(c),
+         static_cast<const Class*>(c)->data(),
+         std::forward<Args>(args)...))) -> decltype(auto)
    {
+      using slot = slot_for<const Class*, Args...>;
       const auto* const ptr = static_cast<const Class*>(c);
-      return get_vtable<
-         InlineVtable,
-         Class,
-         decltype(get_indexer(std::declval<const Class*>(), std::declval<Args>()...))::value>(c)(
-         ptr->data(), std::forward<Args>(args)...);
+      return invoke_slot<slot::pass_object>(
+         get_vtable<Class, slot::value>(c), ptr->data(), std::forward<Args>(args)...);
    }
 
-   template<bool InlineVtable, typename Class, typename... Args>
-   static constexpr auto call(void* c, Args&&... args) noexcept(noexcept(
-      get_vtable<InlineVtable, Class, decltype(get_indexer(std::declval<Class*>(), std::declval<Args>()...))::value>(c)(
-         static_cast<Class*>(c)->data(), std::forward<Args>(args)...))) -> decltype(auto)
+   template<typename Class, typename... Args>
+   static constexpr auto call(void* c, Args&&... args) noexcept(
+      noexcept(invoke_slot<slot_for<Class*, Args...>::pass_object>(
+         get_vtable<Class, slot_for<Class*, Args...>::value>(c),
+         static_cast<Class*>(c)->data(),
+         std::forward<Args>(args)...))) -> decltype(auto)
    {
+      using slot = slot_for<Class*, Args...>;
       auto* const ptr = static_cast<Class*>(c);
-
-      return get_vtable<
-         InlineVtable,
-         Class,
-         decltype(get_indexer(std::declval<Class*>(), std::declval<Args>()...))::value>(c)(
-         ptr->data(), std::forward<Args>(args)...);
+      return invoke_slot<slot::pass_object>(
+         get_vtable<Class, slot::value>(c), ptr->data(), std::forward<Args>(args)...);
    }
 };
 
+consteval auto get_bulk_funcs(std::meta::info trait) -> std::vector<std::meta::info>
+{
+   const auto funcs = get_sorted_funcs_by_name(trait);
+   std::vector<std::meta::info> to_ret;
+   for (const auto f : funcs) {
+      if (std::meta::is_function_template(f) || annotations_of_with_type(f, ^^decltype(bulk)).empty()) {
+         continue;
+      }
+      assert(!std::meta::is_static_member(f) && "Static functions can't be called in bulk");
+      assert(
+         std::ranges::count(funcs, std::meta::identifier_of(f), std::meta::identifier_of) == 1
+         && "Overloaded functions can't be called in bulk");
+      // The results are written to and the arguments read from spans, one element per object
+      assert(
+         !std::meta::is_reference_type(std::meta::return_type_of(f))
+         && "Functions called in bulk must return by value");
+      assert(
+         std::ranges::all_of(
+            std::meta::parameters_of(f),
+            [](const std::meta::info type) {
+               return !std::meta::is_reference_type(type)
+                   || (std::meta::is_lvalue_reference_type(type)
+                       && std::meta::is_const(std::meta::remove_reference(type)));
+            },
+            std::meta::type_of)
+         && "Functions called in bulk must take parameters by value or const reference");
+      to_ret.push_back(f);
+   }
+   return to_ret;
+}
+
+// The spans passed to a bulk function after the object pointer and count:
+// one for the results (unless the function returns void) followed by one per parameter
+consteval auto bulk_span_types(std::meta::info f) -> std::vector<std::meta::info>
+{
+   std::vector<std::meta::info> to_ret;
+   if (std::meta::return_type_of(f) != ^^void) {
+      to_ret.push_back(std::meta::substitute(^^std::span, {std::meta::return_type_of(f)}));
+   }
+   for (const auto i : std::meta::parameters_of(f)) {
+      const auto elem = std::meta::add_const(std::meta::remove_cvref(std::meta::type_of(i)));
+      to_ret.push_back(std::meta::substitute(^^std::span, {elem}));
+   }
+   return to_ret;
+}
+
+consteval auto bulk_slot_type(std::meta::info f) -> std::meta::info
+{
+   std::vector<std::meta::info> infos;
+   infos.push_back(^^void);
+   infos.push_back(std::meta::is_const(f) ? ^^const void* : ^^void*);
+   infos.push_back(^^std::size_t);
+   infos.append_range(bulk_span_types(f));
+   return std::meta::substitute(std::meta::is_noexcept(f) ? ^^noexcept_func_ptr_maker : ^^func_ptr_maker, infos);
+}
+
+// Bulk slots come after the slots for every function in the trait
+consteval auto bulk_slot_index(std::meta::info trait, std::size_t func_index) -> std::size_t
+{
+   const auto funcs = get_sorted_funcs_by_name(trait);
+   const auto bulk_funcs = get_bulk_funcs(trait);
+   const auto it = std::ranges::find(bulk_funcs, funcs[func_index]);
+   assert(it != bulk_funcs.end() && "Only functions marked with khct::bulk can be called in bulk");
+   return funcs.size() + static_cast<std::size_t>(it - bulk_funcs.begin());
+}
+
 consteval auto get_members_and_tuple_type(std::meta::info trait, bool is_owned)
    -> std::pair<std::vector<std::meta::info>, std::vector<std::meta::info>>
 {
@@ -331,7 +541,7 @@ consteval auto get_members_and_tuple_type(std::meta::info trait, bool is_owned)
                      ^^func_caller, {trait, std::meta::reflect_constant(index), std::meta::reflect_constant(is_owned)}),
                   {.name = std::meta::identifier_of(f), .no_unique_address = true})));
          index += 1;
-         func_ptrs.push_back(member_func_to_non_member_func(f, trait));
+         func_ptrs.push_back(vtable_slot_type(f, trait));
       }
       else {
          // Oh no, there's an overload; gotta handle it
@@ -341,7 +551,7 @@ consteval auto get_members_and_tuple_type(std::meta::info trait, bool is_owned)
                   = !annotations_of_with_type(std::meta::substitute(f, {trait}), ^^decltype(default_impl)).empty();
                assert(is_default_impl && "Templated functions can only be used for default implementations");
             }
-            func_ptrs.push_back(member_func_to_non_member_func(f, trait));
+            func_ptrs.push_back(vtable_slot_type(f, trait));
          }
          members.push_back(
             std::meta::reflect_constant(
@@ -356,6 +566,19 @@ consteval auto get_members_and_tuple_type(std::meta::info trait, bool is_owned)
          index += funcs.size();
       }
    }
+   for (const auto f : get_bulk_funcs(trait)) {
+      func_ptrs.push_back(bulk_slot_type(f));
+   }
+   for (const auto field : get_fields(trait)) {
+      members.push_back(
+         std::meta::reflect_constant(
+            std::meta::data_member_spec(
+               std::meta::substitute(
+                  ^^field_ref,
+                  {trait, std::meta::type_of(field), std::meta::reflect_constant(func_ptrs.size() + is_owned)}),
+               {.name = std::meta::identifier_of(field), .no_unique_address = true})));
+      func_ptrs.push_back(^^std::size_t);
+   }
    return {members, func_ptrs};
 }
 
@@ -370,6 +593,81 @@ consteval auto make_owning_dyn_trait(std::meta::info trait) -> std::meta::info
    return std::meta::substitute(^^cls, get_members_and_tuple_type(trait, true).first);
 }
 
+// If the function f of an implementation can be used for trait_func
+consteval auto impl_func_matches(std::meta::info f, std::meta::info trait_func, std::meta::info to_store) -> bool
+{
+   if (std::meta::is_function_template(f)) {
+      return false;
+   }
+   const auto cur_func
+      = std::meta::is_function_template(trait_func) ? std::meta::substitute(trait_func, {to_store}) : trait_func;
+   const auto params1 = std::meta::parameters_of(f);
+   const std::vector<std::meta::info> params2 = std::meta::parameters_of(cur_func)
+                                              | std::views::drop(static_cast<int>(cur_func != trait_func))
+                                              | std::ranges::to<std::vector>();
+
+   if (params1.size() != params2.size()) {
+      return false;
+   }
+
+   for (std::size_t i = 0; i < params1.size(); ++i) {
+      if (std::meta::type_of(params1[i]) != std::meta::type_of(params2[i])) {
+         return false;
+      }
+   }
+
+   // noexcept can decay to non-noexcept
+   // Static trait functions are stored directly, so they must be static in the implementation too
+   return std::meta::return_type_of(f) == std::meta::return_type_of(cur_func)
+       && std::meta::is_const(f) == std::meta::is_const(cur_func)
+       && (std::meta::is_noexcept(f) == std::meta::is_noexcept(cur_func) || !std::meta::is_noexcept(cur_func))
+       && (!std::meta::is_static_member(cur_func) || std::meta::is_static_member(f));
+}
+
+consteval auto find_impl_func(std::meta::info to_store, std::meta::info trait_func) -> std::meta::info
+{
+   for (const auto f : get_impl_funcs(to_store)) {
+      if (std::meta::identifier_of(f) == std::meta::identifier_of(trait_func)
+          && impl_func_matches(f, trait_func, to_store)) {
+         return f;
+      }
+   }
+   return {};
+}
+
+// Implementations provide a batch version of a bulk function as a static function with the same name taking
+// a span of objects followed by the spans of the bulk slot
+consteval auto find_bulk_impl_func(std::meta::info to_store, std::meta::info trait_func) -> std::meta::info
+{
+   std::vector<std::meta::info> expected;
+   const auto obj_type = std::meta::is_const(trait_func) ? std::meta::add_const(to_store) : to_store;
+   expected.push_back(std::meta::substitute(^^std::span, {obj_type}));
+   expected.append_range(bulk_span_types(trait_func));
+
+   for (const auto f : get_sorted_funcs_by_name(to_store)) {
+      if (std::meta::identifier_of(f) != std::meta::identifier_of(trait_func) || !std::meta::is_static_member(f)
+          || std::meta::is_function_template(f) || std::meta::return_type_of(f) != ^^void
+          || (std::meta::is_noexcept(trait_func) && !std::meta::is_noexcept(f))) {
+         continue;
+      }
+      const auto param_types = std::meta::parameters_of(f)
+                             | std::views::transform([](auto p) { return std::meta::dealias(std::meta::type_of(p)); })
+                             | std::ranges::to<std::vector>();
+      if (std::ranges::equal(param_types, expected, {}, {}, std::meta::dealias)) {
+         return f;
+      }
+   }
+   return {};
+}
+
+// A function inherited from a base at the same address is called through the base, so every implementation
+// deriving from it shares one thunk
+consteval auto thunk_class(std::meta::info impl_func, std::meta::info to_store) -> std::meta::info
+{
+   const auto owner = std::meta::parent_of(impl_func);
+   return std::meta::is_pointer_interconvertible_base_of_type(owner, to_store) ? owner : to_store;
+}
+
 template<std::meta::info F, typename Ptr, typename Class, typename... Args>
 constexpr auto produce_func_ptr
    = +[](Ptr c, Args... args) noexcept(noexcept(static_cast<Class>(c)->[:F:](args...))) -> decltype(auto) {
@@ -382,9 +680,27 @@ constexpr auto produce_default_func_ptr
    return Trait{}.[:F:](*static_cast<Class>(c), args...);
 };
 
-template<std::meta::info F, typename... Args>
-constexpr auto produce_default_static_func_ptr
-   = +[](const void*, Args... args) noexcept(noexcept([:F:](args...))) -> decltype(auto) { return [:F:](args...); };
+// F is either the batch function of the implementation (if UseBatch) or the scalar function to loop over
+template<std::meta::info F, bool UseBatch, typename Ptr, typename Class, typename... Spans>
+constexpr auto produce_bulk_func_ptr
+   = +[](Ptr first, const std::size_t count, Spans... spans) noexcept(std::meta::is_noexcept(F)) -> void {
+   const auto objs = static_cast<Class>(first);
+   if constexpr (UseBatch) {
+      [:F:](std::span{objs, count}, spans...);
+   }
+   else if constexpr (std::meta::return_type_of(F) == ^^void) {
+      for (std::size_t i = 0; i < count; ++i) {
+         objs[i].[:F:](spans[i]...);
+      }
+   }
+   else {
+      [&](const auto out, const auto... in) {
+         for (std::size_t i = 0; i < count; ++i) {
+            out[i] = objs[i].[:F:](in[i]...);
+         }
+      }(spans...);
+   }
+};
 
 template<typename Trait, typename ToStore, bool IsOwned>
 constexpr auto make_dyn_trait_pointers(void (*deleter)(void*) noexcept = nullptr) -> auto
@@ -404,7 +720,9 @@ constexpr auto make_dyn_trait_pointers(void (*deleter)(void*) noexcept = nullptr
       return std::define_static_array(trait_funcs);
    }();
 
-   static constexpr auto to_store_func = std::define_static_array(get_sorted_funcs_by_name(^^ToStore));
+   static constexpr auto to_store_func = std::define_static_array(get_impl_funcs(^^ToStore));
+   static constexpr auto bulk_funcs = std::define_static_array(get_bulk_funcs(^^Trait));
+   static constexpr auto fields = std::define_static_array(get_fields(^^Trait));
 
    using ret_type = [:std::meta::substitute(^^detail::tuple, func_ptrs):];
 
@@ -416,10 +734,49 @@ constexpr auto make_dyn_trait_pointers(void (*deleter)(void*) noexcept = nullptr
             if constexpr (I == 0 && IsOwned) {
                return deleter;
             }
+            else if constexpr (I >= trait_funcs.size() + bulk_funcs.size()) {
+               static constexpr auto offset = []() consteval -> std::size_t {
+                  const auto field = fields[I - trait_funcs.size() - bulk_funcs.size()];
+                  for (const auto m : get_fields(^^ToStore)) {
+                     if (std::meta::identifier_of(m) == std::meta::identifier_of(field)
+                         && std::meta::dealias(std::meta::type_of(m)) == std::meta::dealias(std::meta::type_of(field))
+                         && !std::meta::is_bit_field(m)) {
+                        return static_cast<std::size_t>(std::meta::offset_of(m).bytes);
+                     }
+                  }
+                  throw "missing data member";
+               }();
+               return offset;
+            }
+            else if constexpr (I >= trait_funcs.size()) {
+               static constexpr auto to_ret = []() consteval {
+                  const auto f = bulk_funcs[I - trait_funcs.size()];
+                  const auto batch = find_bulk_impl_func(^^ToStore, f);
+                  const auto scalar = find_impl_func(^^ToStore, f);
+                  if (batch == std::meta::info{} && scalar == std::meta::info{}) {
+                     throw "invalid name/no default";
+                  }
+                  std::vector<std::meta::info> args;
+                  args.push_back(std::meta::reflect_constant(batch != std::meta::info{} ? batch : scalar));
+                  args.push_back(std::meta::reflect_constant(batch != std::meta::info{}));
+                  if (std::meta::is_const(f)) {
+                     args.push_back(^^const void*);
+                     args.push_back(^^const ToStore*);
+                  }
+                  else {
+                     args.push_back(^^void*);
+                     args.push_back(^^ToStore*);
+                  }
+                  args.append_range(bulk_span_types(f));
+                  return std::meta::substitute(^^produce_bulk_func_ptr, args);
+               }();
+               return [:to_ret:];
+            }
             else {
                static constexpr auto produce_func_ptr_from_info
                   = [](std::meta::info func_info, std::meta::info sub_into) {
                        const auto is_default = sub_into == ^^produce_default_func_ptr;
+                       const auto cls = is_default ? ^^ToStore : thunk_class(func_info, ^^ToStore);
                        std::vector<std::meta::info> args;
                        args.push_back(std::meta::reflect_constant(func_info));
                        if (is_default) {
@@ -427,11 +784,11 @@ constexpr auto make_dyn_trait_pointers(void (*deleter)(void*) noexcept = nullptr
                        }
                        if (std::meta::is_const(func_info) || std::meta::is_static_member(func_info)) {
                           args.push_back(^^const void*);
-                          args.push_back(^^const ToStore*);
+                          args.push_back(std::meta::add_pointer(std::meta::add_const(cls)));
                        }
                        else {
                           args.push_back(^^void*);
-                          args.push_back(^^ToStore*);
+                          args.push_back(std::meta::add_pointer(cls));
                        }
                        for (const auto arg :
                             std::meta::parameters_of(func_info) | std::views::drop(static_cast<int>(is_default))) {
@@ -442,39 +799,15 @@ constexpr auto make_dyn_trait_pointers(void (*deleter)(void*) noexcept = nullptr
                     };
                template for (constexpr auto f : to_store_func)
                {
-                  static constexpr bool func_signatures_match = []() consteval {
-                     if constexpr (!std::meta::is_function_template(f)) {
-                        const auto cur_func = std::meta::is_function_template(trait_funcs[I])
-                                               ? std::meta::substitute(trait_funcs[I], {^^ToStore})
-                                               : trait_funcs[I];
-                        const auto params1 = std::meta::parameters_of(f);
-                        const std::vector<std::meta::info> params2
-                           = std::meta::parameters_of(cur_func)
-                           | std::views::drop(static_cast<int>(cur_func != trait_funcs[I]))
-                           | std::ranges::to<std::vector>();
-
-                        if (params1.size() != params2.size()) {
-                           return false;
-                        }
-
-                        for (std::size_t i = 0; i < params1.size(); ++i) {
-                           if (std::meta::type_of(params1[i]) != std::meta::type_of(params2[i])) {
-                              return false;
-                           }
-                        }
-
-                        // noexcept can decay to non-noexcept
-                        return std::meta::return_type_of(f) == std::meta::return_type_of(cur_func)
-                            && std::meta::is_const(f) == std::meta::is_const(cur_func)
-                            && (std::meta::is_noexcept(f) == std::meta::is_noexcept(cur_func)
-                                || !std::meta::is_noexcept(cur_func));
-                     }
-
-                     return false;
-                  }();
+                  static constexpr bool func_signatures_match = impl_func_matches(f, trait_funcs[I], ^^ToStore);
                   if constexpr (
                      std::meta::identifier_of(f) == std::meta::identifier_of(trait_funcs[I]) && func_signatures_match) {
-                     return [:produce_func_ptr_from_info(f, ^^produce_func_ptr):];
+                     if constexpr (is_direct_slot(trait_funcs[I])) {
+                        return &[:f:];
+                     }
+                     else {
+                        return [:produce_func_ptr_from_info(f, ^^produce_func_ptr):];
+                     }
                   }
                }
                // Default implementation
@@ -489,24 +822,175 @@ constexpr auto make_dyn_trait_pointers(void (*deleter)(void*) noexcept = nullptr
                else {
                   static constexpr auto is_default = !annotations_of_with_type(f, ^^decltype(default_impl)).empty();
                   if constexpr (is_default && std::meta::is_static_member(trait_funcs[I])) {
-                     static constexpr auto to_ret = []() {
-                        std::vector<std::meta::info> args;
-                        args.push_back(std::meta::reflect_constant(f));
-                        for (const auto arg : std::meta::parameters_of(f)) {
-                           args.push_back(arg);
-                        }
-                        return std::meta::substitute(^^produce_default_static_func_ptr, args);
-                     }();
-                     return [:to_ret:];
+                     return &[:f:];
                   }
                }
                throw "invalid name/no default";
             }
          }.template operator()<Is>()...
       };
-   }.template operator()(std::make_index_sequence<trait_funcs.size()>{});
+   }.template operator()(std::make_index_sequence<func_ptrs.size()>{});
+}
+
+template<typename T>
+constexpr auto destroy_object(void* const c) noexcept -> void
+{
+   static_cast<T*>(c)->~T();
+}
+
+template<typename T>
+auto construct_default(void* const c) -> void
+{
+   new (c) T{};
+}
+
+template<typename T>
+inline constexpr bool is_in_place_type = false;
+
+template<typename T>
+inline constexpr bool is_in_place_type<std::in_place_type_t<T>> = true;
+
+// Shared by all trivially destructible types so they don't each get their own empty destructor
+constexpr auto destroy_nothing(void*) noexcept -> void {}
+
+template<typename T, bool IsOwned>
+consteval auto deleter_for() noexcept -> void (*)(void*) noexcept
+{
+   if constexpr (!IsOwned) {
+      return nullptr;
+   }
+   else if constexpr (std::is_trivially_destructible_v<T>) {
+      return &destroy_nothing;
+   }
+   else {
+      return &destroy_object<T>;
+   }
+}
+
+// A single vtable per (trait, type) pair, shared by every dyn trait struct regardless of its options
+template<typename Trait, typename ToStore, bool IsOwned>
+inline constexpr auto vtable_for = make_dyn_trait_pointers<Trait, ToStore, IsOwned>(deleter_for<ToStore, IsOwned>());
+
+template<typename Trait>
+using vtable_type = [:std::meta::substitute(^^tuple, get_members_and_tuple_type(^^Trait, false).second):];
+
+template<typename Trait>
+using owning_vtable_type = append_tuple_types_t<tuple<void (*)(void*) noexcept>, vtable_type<Trait>>;
+
+// Thin owning dyn traits store a header directly before the object in the same heap block
+template<typename Trait, bool InlineVtable>
+using thin_header_type
+   = std::conditional_t<InlineVtable, owning_vtable_type<Trait>, const owning_vtable_type<Trait>*>;
+
+template<typename T, typename Header>
+struct thin_layout {
+   static constexpr std::size_t align = std::max(alignof(T), alignof(Header));
+   // The offset of the object from the start of the heap block
+   static constexpr std::size_t offset = (sizeof(Header) + align - 1) / align * align;
+   static constexpr std::size_t size = offset + sizeof(T);
+};
+
+template<std::size_t Align>
+struct aligned_delete {
+   static auto operator()(unsigned char* const ptr) noexcept -> void
+   {
+      ::operator delete(ptr, std::align_val_t{Align});
+   }
+};
+
+template<typename T, typename Header>
+auto destroy_thin(void* const c) noexcept -> void
+{
+   using layout = thin_layout<T, Header>;
+   static_cast<T*>(c)->~T();
+   aligned_delete<layout::align>{}(static_cast<unsigned char*>(c) - layout::offset);
 }
 
+template<typename Trait, typename ToStore, typename Header>
+inline constexpr auto thin_vtable_for = make_dyn_trait_pointers<Trait, ToStore, true>(&destroy_thin<ToStore, Header>);
+
+template<typename Handle>
+struct handle_traits;
+
+template<typename Trait, non_owning_dyn_options Opt>
+struct handle_traits<non_owning_dyn_trait<Trait, Opt>> {
+   static constexpr bool inline_vtable = Opt.store_vtable_inline;
+
+   // The vtable used for objects of type T
+   template<typename T>
+   static constexpr const auto& vtable = vtable_for<std::remove_const_t<Trait>, T, false>;
+};
+
+template<typename Trait, owning_dyn_options Opt>
+struct handle_traits<owning_dyn_trait<Trait, Opt>> {
+   static constexpr bool inline_vtable = Opt.store_vtable_inline;
+
+   template<typename T>
+   static constexpr const auto& vtable = vtable_for<Trait, T, true>;
+};
+
+template<typename Trait, thin_owning_dyn_options Opt>
+struct handle_traits<thin_owning_dyn_trait<Trait, Opt>> {
+   static constexpr bool inline_vtable = Opt.store_vtable_inline;
+
+   template<typename T>
+   static constexpr const auto& vtable = thin_vtable_for<Trait, T, thin_header_type<Trait, Opt.store_vtable_inline>>;
+};
+
+template<typename Trait, typename T>
+struct handle_traits<static_dyn<Trait, T>> {
+   static constexpr bool inline_vtable = false;
+
+   template<typename U>
+   static constexpr const auto& vtable = vtable_for<std::remove_const_t<Trait>, U, false>;
+};
+
+// Gives the free functions of the library access to the internals of dyn trait structs
+struct handle_access {
+   template<typename Handle>
+   static constexpr auto data(Handle& h) noexcept -> auto
+   {
+      return h.data();
+   }
+
+   template<typename Handle, typename... Parts>
+   static constexpr auto from_parts(Parts&&... parts) noexcept -> Handle
+   {
+      return Handle{from_parts_tag{}, std::forward<Parts>(parts)...};
+   }
+
+   // Gives up ownership of the object of a thin owning dyn trait
+   template<typename Handle>
+   static constexpr auto release(Handle& h) noexcept -> void*
+   {
+      return std::exchange(h.data_, nullptr);
+   }
+
+   // If h refers to an object of type T
+   template<typename T, typename Handle>
+   static constexpr auto holds(const Handle& h) noexcept -> bool
+   {
+      using traits = handle_traits<Handle>;
+      if constexpr (traits::inline_vtable) {
+         return h.vtable() == traits::template vtable<T>;
+      }
+      else {
+         return &h.vtable() == &traits::template vtable<T>;
+      }
+   }
+
+   template<typename Handle>
+   static constexpr auto vtable_less(const Handle& lhs, const Handle& rhs) noexcept -> bool
+   {
+      if constexpr (handle_traits<Handle>::inline_vtable) {
+         return lhs.vtable() < rhs.vtable();
+      }
+      else {
+         return std::less<>{}(&lhs.vtable(), &rhs.vtable());
+      }
+   }
+};
+
 template<typename Trait>
 using non_owning_dyn_trait_impl = [:make_non_owning_dyn_trait(^^Trait):];
 
@@ -516,20 +1000,63 @@ using owning_dyn_trait_impl = [:make_owning_dyn_trait<Opt>(^^Trait):];
 } // namespace detail
 
 template<typename T>
-inline constexpr auto default_non_owning_opt_for
-   = non_owning_dyn_options{.store_vtable_inline = detail::get_sorted_funcs_by_name(^^T).size() <= 1};
+inline constexpr auto default_non_owning_opt_for = non_owning_dyn_options{
+   // Counts bulk and data member slots too, since those are also stored in the vtable
+   .store_vtable_inline = detail::get_members_and_tuple_type(^^std::remove_const_t<T>, false).second.size() <= 1};
 
 template<typename T>
 inline constexpr auto default_owning_opt_for = owning_dyn_options{.store_vtable_inline = false, .stack_size = 0};
 
+struct vtable_stats {
+   /// @brief The number of slots in a non-owning vtable.
+   ///        Slots that are neither direct nor thunks hold data member offsets.
+   std::size_t slot_count;
+   /// @brief The number of slots that point directly at the implementation.
+   std::size_t direct_slot_count;
+   /// @brief The number of slots that point at a generated thunk.
+   ///        Each thunk is emitted once per (trait, implementation) pair.
+   std::size_t thunk_slot_count;
+   /// @brief The size in bytes of a vtable used by non-owning dyn traits.
+   std::size_t non_owning_vtable_size;
+   /// @brief The size in bytes of a vtable used by owning dyn traits.
+   std::size_t owning_vtable_size;
+};
+
+template<typename Trait>
+inline constexpr auto vtable_stats_for = []() consteval {
+   const auto funcs = detail::get_sorted_funcs_by_name(^^Trait);
+   const auto bulk_funcs = detail::get_bulk_funcs(^^Trait).size();
+   const auto direct = static_cast<std::size_t>(std::ranges::count_if(funcs, detail::is_direct_slot));
+   return vtable_stats{
+      .slot_count = funcs.size() + bulk_funcs + detail::get_fields(^^Trait).size(),
+      .direct_slot_count = direct,
+      .thunk_slot_count = funcs.size() - direct + bulk_funcs,
+      .non_owning_vtable_size = sizeof(detail::vtable_type<Trait>),
+      .owning_vtable_size = sizeof(detail::owning_vtable_type<Trait>),
+   };
+}();
+
+/// @brief Everything needed to create an implementation of Trait without knowing its type.
+template<typename Trait>
+struct impl_entry {
+   std::string_view name;
+   std::size_t size;
+   std::size_t align;
+   /// @brief Default constructs the implementation at the given address.
+   void (*construct)(void*);
+   const detail::owning_vtable_type<Trait>* vtable;
+};
+
 template<typename Trait, non_owning_dyn_options Opt = default_non_owning_opt_for<Trait>>
 struct non_owning_dyn_trait trivially_relocatable_if_eligible replaceable_if_eligible
    : detail::non_owning_dyn_trait_impl<std::remove_const_t<Trait>> {
    template<typename TraitClass, auto... Rest>
    friend struct detail::func_caller;
 
-   template<bool InlineVtable, typename Class, std::size_t I>
-   friend constexpr auto detail::get_vtable(auto* c) noexcept -> auto&;
+   template<typename Class, std::size_t I>
+   friend constexpr auto detail::get_vtable(const void* c) noexcept -> const auto&;
+
+   friend struct detail::handle_access;
 
    non_owning_dyn_trait() = delete;
    non_owning_dyn_trait(const non_owning_dyn_trait&) = default;
@@ -550,32 +1077,100 @@ struct non_owning_dyn_trait trivially_relocatable_if_eligible replaceable_if_eli
    template<auto... FuncCallerRest, typename... T>
    constexpr auto
       call(detail::func_caller<std::remove_const_t<Trait>, FuncCallerRest...> to_call, T&&... args) noexcept(
-         noexcept(to_call.template call<Opt.store_vtable_inline, std::remove_reference_t<decltype(*this)>>(
+         noexcept(to_call.template call<std::remove_reference_t<decltype(*this)>>(
             this, std::forward<T>(args)...))) -> decltype(auto)
    {
-      return to_call.template call<Opt.store_vtable_inline, std::remove_reference_t<decltype(*this)>>(
+      return to_call.template call<std::remove_reference_t<decltype(*this)>>(
          this, std::forward<T>(args)...);
    }
 
    template<auto... FuncCallerRest, typename... T>
    constexpr auto call(detail::func_caller<std::remove_const_t<Trait>, FuncCallerRest...> to_call, T&&... args) const
-      noexcept(noexcept(to_call.template call<Opt.store_vtable_inline, std::remove_reference_t<decltype(*this)>>(
+      noexcept(noexcept(to_call.template call<std::remove_reference_t<decltype(*this)>>(
          this, std::forward<T>(args)...))) -> decltype(auto)
    {
-      return to_call.template call<Opt.store_vtable_inline, std::remove_reference_t<decltype(*this)>>(
+      return to_call.template call<std::remove_reference_t<decltype(*this)>>(
          this, std::forward<T>(args)...);
    }
 
+   /// @brief Calls a function marked with khct::bulk on count objects of the same type stored contiguously
+   ///        starting at the object this refers to.
+   ///        Every span must have at least count elements.
+   template<std::size_t FuncIndex, typename... T>
+   constexpr auto call_bulk(
+      detail::func_caller<std::remove_const_t<Trait>, FuncIndex, false>,
+      const std::size_t count,
+      T&&... spans) noexcept(noexcept(detail::get_vtable<non_owning_dyn_trait, bulk_index<FuncIndex>>(
+      this)(data(), count, std::forward<T>(spans)...))) -> void
+   {
+      assert(((std::ranges::size(spans) >= count) && ...) && "Every span must have at least count elements");
+      detail::get_vtable<non_owning_dyn_trait, bulk_index<FuncIndex>>(this)(
+         data(), count, std::forward<T>(spans)...);
+   }
+
+   template<std::size_t FuncIndex, typename... T>
+   constexpr auto call_bulk(
+      detail::func_caller<std::remove_const_t<Trait>, FuncIndex, false>,
+      const std::size_t count,
+      T&&... spans) const
+      noexcept(noexcept(detail::get_vtable<non_owning_dyn_trait, bulk_index<FuncIndex>>(
+         this)(data(), count, std::forward<T>(spans)...))) -> void
+   {
+      assert(((std::ranges::size(spans) >= count) && ...) && "Every span must have at least count elements");
+      detail::get_vtable<non_owning_dyn_trait, bulk_index<FuncIndex>>(this)(
+         data(), count, std::forward<T>(spans)...);
+   }
+
+   /// @brief Accesses a data member of the trait without calling a function
+   template<typename T, std::size_t SlotIndex>
+      requires(!std::is_const_v<Trait>)
+   auto get(detail::field_ref<std::remove_const_t<Trait>, T, SlotIndex>) noexcept -> T&
+   {
+      const auto offset = detail::get_vtable<non_owning_dyn_trait, SlotIndex>(this);
+      return *static_cast<T*>(static_cast<void*>(static_cast<unsigned char*>(data()) + offset));
+   }
+
+   template<typename T, std::size_t SlotIndex>
+   auto get(detail::field_ref<std::remove_const_t<Trait>, T, SlotIndex>) const noexcept -> const T&
+   {
+      const auto offset = detail::get_vtable<non_owning_dyn_trait, SlotIndex>(this);
+      return *static_cast<const T*>(static_cast<const void*>(static_cast<const unsigned char*>(data()) + offset));
+   }
+
 private:
    using base = detail::non_owning_dyn_trait_impl<Trait>;
 
-   using tuple_func_ptrs
-      = [:std::meta::substitute(^^detail::tuple, detail::get_members_and_tuple_type(^^Trait, false).second):];
+   template<std::size_t FuncIndex>
+   static constexpr std::size_t bulk_index = detail::bulk_slot_index(^^std::remove_const_t<Trait>, FuncIndex);
+
+   using tuple_func_ptrs = detail::vtable_type<std::remove_const_t<Trait>>;
 
    std::conditional_t<std::is_const_v<Trait>, const void*, void*> data_;
    std::conditional_t<Opt.store_vtable_inline, tuple_func_ptrs, std::add_pointer_t<std::add_const_t<tuple_func_ptrs>>>
       funcs_;
 
+   constexpr non_owning_dyn_trait(
+      detail::from_parts_tag, decltype(data_) data, const tuple_func_ptrs& funcs) noexcept
+      : data_{data}, funcs_{[&]() -> decltype(funcs_) {
+           if constexpr (Opt.store_vtable_inline) {
+              return funcs;
+           }
+           else {
+              return &funcs;
+           }
+        }()}
+   {}
+
+   constexpr auto vtable() const noexcept -> const tuple_func_ptrs&
+   {
+      if constexpr (Opt.store_vtable_inline) {
+         return funcs_;
+      }
+      else {
+         return *funcs_;
+      }
+   }
+
    // clang-format off
    constexpr auto data() noexcept -> void*
       requires(!std::is_const_v<Trait>)
@@ -593,11 +1188,10 @@ private:
    static constexpr auto gen_funcs() noexcept -> auto
    {
       if constexpr (Opt.store_vtable_inline) {
-         return detail::make_dyn_trait_pointers<std::remove_const_t<Trait>, ToStore, false>();
+         return detail::vtable_for<std::remove_const_t<Trait>, ToStore, false>;
       }
       else {
-         return detail::define_static_object(
-            detail::make_dyn_trait_pointers<std::remove_const_t<Trait>, ToStore, false>());
+         return &detail::vtable_for<std::remove_const_t<Trait>, ToStore, false>;
       }
    };
 };
@@ -608,8 +1202,16 @@ struct owning_dyn_trait trivially_relocatable_if_eligible replaceable_if_eligibl
    template<typename TraitClass, auto... Rest>
    friend struct detail::func_caller;
 
-   template<bool InlineVtable, typename Class, std::size_t I>
-   friend constexpr auto detail::get_vtable(auto* c) noexcept -> auto&;
+   template<typename Class, std::size_t I>
+   friend constexpr auto detail::get_vtable(const void* c) noexcept -> const auto&;
+
+   friend struct detail::handle_access;
+
+   /// @brief The largest alignment of an object that can be stored.
+   ///        Heap storage comes from new[], which only guarantees the default new alignment.
+   static constexpr std::size_t storage_align = Opt.stack_size == 0 ? __STDCPP_DEFAULT_NEW_ALIGNMENT__
+                                              : Opt.stack_align == 0 ? alignof(std::max_align_t)
+                                                                     : Opt.stack_align;
 
    owning_dyn_trait() = delete;
    // Disallow copying (for now?)
@@ -635,55 +1237,105 @@ struct owning_dyn_trait trivially_relocatable_if_eligible replaceable_if_eligibl
    // TODO: Add a "alloc never throws" option
    template<typename ToStore>
       requires((sizeof(ToStore) <= Opt.stack_size || Opt.stack_size == 0)
-               && (detail::is_auto_trait<Trait> || detail::is_trait_impl_for<Trait, std::remove_reference_t<ToStore>>))
+               && alignof(std::remove_cvref_t<ToStore>) <= storage_align
+               && !std::is_same_v<std::remove_cvref_t<ToStore>, impl_entry<Trait>>
+               && !detail::is_in_place_type<std::remove_cvref_t<ToStore>>
+               && (detail::is_auto_trait<Trait> || detail::is_trait_impl_for<Trait, std::remove_cvref_t<ToStore>>))
    explicit constexpr owning_dyn_trait(ToStore&& obj) noexcept(
-      Opt.stack_size == 0 && noexcept(new (data()) std::remove_reference_t<ToStore>{std::forward<ToStore>(obj)}))
-      : data_{gen_data<ToStore>()}, funcs_{gen_funcs<std::remove_reference_t<ToStore>>()}
+      Opt.stack_size == 0 && noexcept(new (data()) std::remove_cvref_t<ToStore>{std::forward<ToStore>(obj)}))
+      : data_{gen_data(sizeof(std::remove_cvref_t<ToStore>))}, funcs_{gen_funcs<std::remove_cvref_t<ToStore>>()}
+   {
+      new (data()) std::remove_cvref_t<ToStore>{std::forward<ToStore>(obj)};
+   }
+
+   /// @brief Constructs a ToStore from args directly in the storage, without a temporary to move from.
+   template<typename ToStore, typename... Args>
+      requires((sizeof(ToStore) <= Opt.stack_size || Opt.stack_size == 0) && alignof(ToStore) <= storage_align
+               && std::is_constructible_v<ToStore, Args...>
+               && (detail::is_auto_trait<Trait> || detail::is_trait_impl_for<Trait, ToStore>))
+   explicit constexpr owning_dyn_trait(std::in_place_type_t<ToStore>, Args&&... args) noexcept(
+      Opt.stack_size > 0 && std::is_nothrow_constructible_v<ToStore, Args...>)
+      : data_{gen_data(sizeof(ToStore))}, funcs_{gen_funcs<ToStore>()}
    {
-      new (data()) std::remove_reference_t<ToStore>{std::forward<ToStore>(obj)};
+      new (data()) ToStore(std::forward<Args>(args)...);
+   }
+
+   /// @brief Default constructs the implementation described by entry, such as one found in an impl_registry.
+   ///        Throws std::invalid_argument if the implementation is too large or too aligned for the storage.
+   explicit owning_dyn_trait(const impl_entry<Trait>& entry)
+      : data_{gen_data(checked_size(entry))}, funcs_{[&]() -> decltype(funcs_) {
+           if constexpr (Opt.store_vtable_inline) {
+              return *entry.vtable;
+           }
+           else {
+              return entry.vtable;
+           }
+        }()}
+   {
+      entry.construct(data());
    }
 
    constexpr ~owning_dyn_trait()
    {
       if (data()) {
-         if constexpr (Opt.store_vtable_inline) {
-            this->funcs_.template get<0>()(data());
-         }
-         else {
-            this->funcs_->template get<0>()(data());
-         }
+         vtable().template get<0>()(data());
       }
    }
 
    template<auto... FuncCallerRest, typename... T>
    constexpr auto call(detail::func_caller<Trait, FuncCallerRest...> to_call, T&&... args) noexcept(
-      noexcept(to_call.template call<Opt.store_vtable_inline, std::remove_reference_t<decltype(*this)>>(
+      noexcept(to_call.template call<std::remove_reference_t<decltype(*this)>>(
          this, std::forward<T>(args)...))) -> decltype(auto)
    {
-      return to_call.template call<Opt.store_vtable_inline, std::remove_reference_t<decltype(*this)>>(
+      return to_call.template call<std::remove_reference_t<decltype(*this)>>(
          this, std::forward<T>(args)...);
    }
 
    template<auto... FuncCallerRest, typename... T>
    constexpr auto call(detail::func_caller<Trait, FuncCallerRest...> to_call, T&&... args) const
-      noexcept(noexcept(to_call.template call<Opt.store_vtable_inline, std::remove_reference_t<decltype(*this)>>(
+      noexcept(noexcept(to_call.template call<std::remove_reference_t<decltype(*this)>>(
          this, std::forward<T>(args)...))) -> decltype(auto)
    {
-      return to_call.template call<Opt.store_vtable_inline, std::remove_reference_t<decltype(*this)>>(
+      return to_call.template call<std::remove_reference_t<decltype(*this)>>(
          this, std::forward<T>(args)...);
    }
 
+   /// @brief Accesses a data member of the trait without calling a function
+   template<typename T, std::size_t SlotIndex>
+   auto get(detail::field_ref<Trait, T, SlotIndex>) noexcept -> T&
+   {
+      const auto offset = detail::get_vtable<owning_dyn_trait, SlotIndex>(this);
+      return *static_cast<T*>(static_cast<void*>(static_cast<unsigned char*>(data()) + offset));
+   }
+
+   template<typename T, std::size_t SlotIndex>
+   auto get(detail::field_ref<Trait, T, SlotIndex>) const noexcept -> const T&
+   {
+      const auto offset = detail::get_vtable<owning_dyn_trait, SlotIndex>(this);
+      return *static_cast<const T*>(static_cast<const void*>(static_cast<const unsigned char*>(data()) + offset));
+   }
+
 private:
    using base = detail::owning_dyn_trait_impl<Trait, Opt>;
-   using tuple_func_ptrs = detail::append_tuple_types_t<
-      detail::tuple<void (*)(void*) noexcept>,
-      typename[:std::meta::substitute(^^detail::tuple, detail::get_members_and_tuple_type(^^Trait, true).second):]>;
+   using tuple_func_ptrs = detail::owning_vtable_type<Trait>;
+   using storage_type = std::conditional_t<(Opt.stack_size > 0),
+                                           std::array<unsigned char, Opt.stack_size>,
+                                           std::unique_ptr<unsigned char[]>>;
 
-   std::conditional_t<(Opt.stack_size > 0), std::array<unsigned char, Opt.stack_size>, std::unique_ptr<unsigned char[]>>
-      data_;
+   alignas(Opt.stack_size > 0 ? storage_align : alignof(storage_type)) storage_type data_;
    std::conditional_t<Opt.store_vtable_inline, tuple_func_ptrs, std::add_pointer_t<std::add_const_t<tuple_func_ptrs>>>
       funcs_;
 
+   constexpr auto vtable() const noexcept -> const tuple_func_ptrs&
+   {
+      if constexpr (Opt.store_vtable_inline) {
+         return funcs_;
+      }
+      else {
+         return *funcs_;
+      }
+   }
+
    constexpr auto data() noexcept -> void*
    {
       if constexpr (Opt.stack_size > 0) {
@@ -704,32 +1356,298 @@ private:
       }
    }
 
-   template<typename ToStore>
-   static constexpr auto gen_data() noexcept -> auto
+   static constexpr auto gen_data([[maybe_unused]] const std::size_t size) noexcept -> auto
    {
       if constexpr (Opt.stack_size > 0) {
          return std::array<unsigned char, Opt.stack_size>{};
       }
       else {
-         return std::make_unique<unsigned char[]>(sizeof(ToStore));
+         return std::make_unique<unsigned char[]>(size);
       }
    };
 
+   // Checked before gen_data so nothing is allocated for an entry that doesn't fit
+   static auto checked_size(const impl_entry<Trait>& entry) -> std::size_t
+   {
+      if ((Opt.stack_size > 0 && entry.size > Opt.stack_size) || entry.align > storage_align) {
+         throw std::invalid_argument{"Implementation does not fit in the storage"};
+      }
+      return entry.size;
+   }
+
    template<typename ToStore>
    static constexpr auto gen_funcs() noexcept -> auto
    {
       if constexpr (Opt.store_vtable_inline) {
-         return detail::make_dyn_trait_pointers<Trait, ToStore, true>(
-            [](void* const c) noexcept { static_cast<ToStore*>(c)->~ToStore(); });
+         return detail::vtable_for<Trait, ToStore, true>;
       }
       else {
-         return detail::define_static_object(
-            detail::make_dyn_trait_pointers<Trait, ToStore, true>(
-               [](void* const c) noexcept { static_cast<ToStore*>(c)->~ToStore(); }));
+         return &detail::vtable_for<Trait, ToStore, true>;
       }
    };
 };
 
+/// @brief An owning dyn trait that is a single pointer.
+///        The object is always heap allocated, with the vtable (or a pointer to it) stored directly before it.
+template<typename Trait, thin_owning_dyn_options Opt = thin_owning_dyn_options{}>
+struct thin_owning_dyn_trait trivially_relocatable_if_eligible replaceable_if_eligible
+   : detail::owning_dyn_trait_impl<Trait, owning_dyn_options{}> {
+   template<typename TraitClass, auto... Rest>
+   friend struct detail::func_caller;
+
+   template<typename Class, std::size_t I>
+   friend constexpr auto detail::get_vtable(const void* c) noexcept -> const auto&;
+
+   friend struct detail::handle_access;
+
+   thin_owning_dyn_trait() = delete;
+   thin_owning_dyn_trait(const thin_owning_dyn_trait&) = delete;
+   thin_owning_dyn_trait& operator=(const thin_owning_dyn_trait&) = delete;
+
+   thin_owning_dyn_trait(thin_owning_dyn_trait&& other) noexcept : data_{std::exchange(other.data_, nullptr)} {}
+
+   thin_owning_dyn_trait& operator=(thin_owning_dyn_trait&& other) noexcept
+   {
+      if (this != &other) {
+         destroy();
+         data_ = std::exchange(other.data_, nullptr);
+      }
+      return *this;
+   }
+
+   template<typename ToStore>
+      requires(!std::is_same_v<std::remove_cvref_t<ToStore>, thin_owning_dyn_trait>
+               && (detail::is_auto_trait<Trait> || detail::is_trait_impl_for<Trait, std::remove_cvref_t<ToStore>>))
+   explicit thin_owning_dyn_trait(ToStore&& obj)
+   {
+      using type = std::remove_cvref_t<ToStore>;
+      using layout = detail::thin_layout<type, header_type>;
+      std::unique_ptr<unsigned char, detail::aligned_delete<layout::align>> block{
+         static_cast<unsigned char*>(::operator new(layout::size, std::align_val_t{layout::align}))};
+      new (block.get() + layout::offset) type{std::forward<ToStore>(obj)};
+
+      static constexpr const auto& funcs = detail::thin_vtable_for<Trait, type, header_type>;
+      if constexpr (Opt.store_vtable_inline) {
+         new (block.get() + layout::offset - sizeof(header_type)) header_type{funcs};
+      }
+      else {
+         new (block.get() + layout::offset - sizeof(header_type)) header_type{&funcs};
+      }
+      data_ = block.release() + layout::offset;
+   }
+
+   ~thin_owning_dyn_trait() { destroy(); }
+
+   template<auto... FuncCallerRest, typename... T>
+   constexpr auto call(detail::func_caller<Trait, FuncCallerRest...> to_call, T&&... args) noexcept(
+      noexcept(to_call.template call<std::remove_reference_t<decltype(*this)>>(
+         this, std::forward<T>(args)...))) -> decltype(auto)
+   {
+      return to_call.template call<std::remove_reference_t<decltype(*this)>>(
+         this, std::forward<T>(args)...);
+   }
+
+   template<auto... FuncCallerRest, typename... T>
+   constexpr auto call(detail::func_caller<Trait, FuncCallerRest...> to_call, T&&... args) const
+      noexcept(noexcept(to_call.template call<std::remove_reference_t<decltype(*this)>>(
+         this, std::forward<T>(args)...))) -> decltype(auto)
+   {
+      return to_call.template call<std::remove_reference_t<decltype(*this)>>(
+         this, std::forward<T>(args)...);
+   }
+
+   /// @brief Accesses a data member of the trait without calling a function
+   template<typename T, std::size_t SlotIndex>
+   auto get(detail::field_ref<Trait, T, SlotIndex>) noexcept -> T&
+   {
+      const auto offset = detail::get_vtable<thin_owning_dyn_trait, SlotIndex>(this);
+      return *static_cast<T*>(static_cast<void*>(static_cast<unsigned char*>(data()) + offset));
+   }
+
+   template<typename T, std::size_t SlotIndex>
+   auto get(detail::field_ref<Trait, T, SlotIndex>) const noexcept -> const T&
+   {
+      const auto offset = detail::get_vtable<thin_owning_dyn_trait, SlotIndex>(this);
+      return *static_cast<const T*>(static_cast<const void*>(static_cast<const unsigned char*>(data()) + offset));
+   }
+
+private:
+   using tuple_func_ptrs = detail::owning_vtable_type<Trait>;
+   using header_type = detail::thin_header_type<Trait, Opt.store_vtable_inline>;
+
+   void* data_;
+
+   // Takes ownership of an object that was created by another thin owning dyn trait with the same options
+   thin_owning_dyn_trait(detail::from_parts_tag, void* const data) noexcept : data_{data} {}
+
+   auto header() const noexcept -> const header_type&
+   {
+      return *std::launder(static_cast<const header_type*>(
+         static_cast<const void*>(static_cast<const unsigned char*>(data_) - sizeof(header_type))));
+   }
+
+   auto vtable() const noexcept -> const tuple_func_ptrs&
+   {
+      if constexpr (Opt.store_vtable_inline) {
+         return header();
+      }
+      else {
+         return *header();
+      }
+   }
+
+   constexpr auto data() noexcept -> void* { return data_; }
+
+   constexpr auto data() const noexcept -> const void* { return data_; }
+
+   auto destroy() noexcept -> void
+   {
+      if (data_) {
+         // This also frees the heap block
+         vtable().template get<0>()(data_);
+      }
+   }
+};
+
+namespace detail {
+
+// Calls the function of T used for the trait function at FuncIndex directly, rather than through a vtable.
+// The function is found the same way as for the vtable slot.
+template<typename Trait, typename T, std::size_t FuncIndex>
+struct static_caller {
+   static constexpr auto trait_func = get_sorted_funcs_by_name(^^Trait)[FuncIndex];
+   static constexpr auto impl_func = find_impl_func(^^T, trait_func);
+   static constexpr auto is_default = !annotations_of_with_type(
+                                         std::meta::is_function_template(trait_func)
+                                            ? std::meta::substitute(trait_func, {^^T})
+                                            : trait_func,
+                                         ^^decltype(default_impl))
+                                         .empty();
+
+   template<typename Obj, typename... Args>
+      requires(impl_func != std::meta::info{} && !std::meta::is_static_member(impl_func))
+   static constexpr auto call(Obj* obj, Args&&... args) noexcept(noexcept(obj->[:impl_func:](
+      std::forward<Args>(args)...))) -> decltype(auto)
+   {
+      return obj->[:impl_func:](std::forward<Args>(args)...);
+   }
+
+   template<typename Obj, typename... Args>
+      requires(impl_func != std::meta::info{} && std::meta::is_static_member(impl_func))
+   static constexpr auto call(Obj*, Args&&... args) noexcept(noexcept([:impl_func:](std::forward<Args>(args)...)))
+      -> decltype(auto)
+   {
+      return [:impl_func:](std::forward<Args>(args)...);
+   }
+
+   template<typename Obj, typename... Args>
+      requires(impl_func == std::meta::info{} && is_default && std::meta::is_function_template(trait_func))
+   static constexpr auto call(Obj* obj, Args&&... args) noexcept(
+      noexcept(Trait{}.[:std::meta::substitute(trait_func, {^^T}):](*obj, std::forward<Args>(args)...)))
+      -> decltype(auto)
+   {
+      return Trait{}.[:std::meta::substitute(trait_func, {^^T}):](*obj, std::forward<Args>(args)...);
+   }
+
+   template<typename Obj, typename... Args>
+      requires(impl_func == std::meta::info{} && is_default && std::meta::is_static_member(trait_func)
+               && !std::meta::is_function_template(trait_func))
+   static constexpr auto call(Obj*, Args&&... args) noexcept(noexcept([:trait_func:](std::forward<Args>(args)...)))
+      -> decltype(auto)
+   {
+      return [:trait_func:](std::forward<Args>(args)...);
+   }
+};
+
+} // namespace detail
+
+/// @brief Has the same interface as non_owning_dyn_trait, but only refers to objects of type T.
+///        Calls are bound to the functions of T at compile time instead of going through a vtable, so they can
+///        be inlined, and return what the function of T returns.
+///        This allows writing code once against the dyn trait interface and choosing per call site
+///        whether to type erase.
+template<typename Trait, typename T>
+struct static_dyn trivially_relocatable_if_eligible replaceable_if_eligible
+   : detail::non_owning_dyn_trait_impl<std::remove_const_t<Trait>> {
+   template<typename TraitClass, auto... Rest>
+   friend struct detail::func_caller;
+
+   template<typename Class, std::size_t I>
+   friend constexpr auto detail::get_vtable(const void* c) noexcept -> const auto&;
+
+   friend struct detail::handle_access;
+
+   static_dyn() = delete;
+
+   explicit constexpr static_dyn(std::conditional_t<std::is_const_v<Trait>, const T*, T*> ptr) noexcept
+      requires(detail::is_auto_trait<std::remove_const_t<Trait>> || detail::is_trait_impl_for<Trait, T>)
+      : data_{ptr}
+   {}
+
+   template<auto... FuncCallerRest, typename... Args>
+   constexpr auto
+      call(detail::func_caller<std::remove_const_t<Trait>, FuncCallerRest...> to_call, Args&&... args) noexcept(
+         noexcept(caller_for<decltype(to_call), static_dyn*, Args...>::call(data_, std::forward<Args>(args)...)))
+         -> decltype(auto)
+   {
+      return caller_for<decltype(to_call), static_dyn*, Args...>::call(data_, std::forward<Args>(args)...);
+   }
+
+   template<auto... FuncCallerRest, typename... Args>
+   constexpr auto
+      call(detail::func_caller<std::remove_const_t<Trait>, FuncCallerRest...> to_call, Args&&... args) const
+      noexcept(noexcept(caller_for<decltype(to_call), const static_dyn*, Args...>::call(
+         std::declval<const T*>(), std::forward<Args>(args)...))) -> decltype(auto)
+   {
+      const T* const obj = data_;
+      return caller_for<decltype(to_call), const static_dyn*, Args...>::call(obj, std::forward<Args>(args)...);
+   }
+
+   /// @brief Accesses a data member of the trait without calling a function
+   template<typename U, std::size_t SlotIndex>
+      requires(!std::is_const_v<Trait>)
+   auto get(detail::field_ref<std::remove_const_t<Trait>, U, SlotIndex>) noexcept -> U&
+   {
+      const auto offset = detail::get_vtable<static_dyn, SlotIndex>(this);
+      return *static_cast<U*>(static_cast<void*>(static_cast<unsigned char*>(data()) + offset));
+   }
+
+   template<typename U, std::size_t SlotIndex>
+   auto get(detail::field_ref<std::remove_const_t<Trait>, U, SlotIndex>) const noexcept -> const U&
+   {
+      const auto offset = detail::get_vtable<static_dyn, SlotIndex>(this);
+      return *static_cast<const U*>(static_cast<const void*>(static_cast<const unsigned char*>(data()) + offset));
+   }
+
+private:
+   using tuple_func_ptrs = detail::vtable_type<std::remove_const_t<Trait>>;
+
+   // Picks the trait function the same way as the dyn trait structs, but calls the function of T directly
+   template<typename FuncCaller, typename Ptr, typename... Args>
+   using caller_for
+      = detail::static_caller<std::remove_const_t<Trait>, T, FuncCaller::template func_index<Ptr, Args...>>;
+
+   std::conditional_t<std::is_const_v<Trait>, const T*, T*> data_;
+
+   static constexpr auto vtable() noexcept -> const tuple_func_ptrs&
+   {
+      return detail::vtable_for<std::remove_const_t<Trait>, T, false>;
+   }
+
+   // clang-format off
+   constexpr auto data() noexcept -> void*
+      requires(!std::is_const_v<Trait>)
+   {
+      return this->data_;
+   }
+
+   constexpr auto data() const noexcept -> const void*
+   {
+      return this->data_;
+   }
+   // clang-format on
+};
+
 template<typename DynTrait, non_owning_dyn_options Opt = default_non_owning_opt_for<DynTrait>, typename ToStore>
    requires(
       std::is_const_v<DynTrait> && (detail::is_auto_trait<DynTrait> || detail::is_trait_impl_for<DynTrait, ToStore>))
@@ -746,7 +1664,7 @@ template<typename DynTrait, non_owning_dyn_options Opt = default_non_owning_opt_
 }
 
 template<typename DynTrait, owning_dyn_options Opt = default_owning_opt_for<DynTrait>, typename ToStore>
-   requires(detail::is_auto_trait<DynTrait> || detail::is_trait_impl_for<DynTrait, std::remove_reference_t<ToStore>>)
+   requires(detail::is_auto_trait<DynTrait> || detail::is_trait_impl_for<DynTrait, std::remove_cvref_t<ToStore>>)
 [[nodiscard]] constexpr auto
    owning_dyn(ToStore&& to_store) noexcept(noexcept(owning_dyn_trait<DynTrait, Opt>{std::forward<ToStore>(to_store)}))
       -> owning_dyn_trait<DynTrait, Opt>
@@ -754,6 +1672,933 @@ template<typename DynTrait, owning_dyn_options Opt = default_owning_opt_for<DynT
    return owning_dyn_trait<DynTrait, Opt>{std::forward<ToStore>(to_store)};
 }
 
+template<typename DynTrait, thin_owning_dyn_options Opt = thin_owning_dyn_options{}, typename ToStore>
+   requires(detail::is_auto_trait<DynTrait> || detail::is_trait_impl_for<DynTrait, std::remove_cvref_t<ToStore>>)
+[[nodiscard]] auto thin_owning_dyn(ToStore&& to_store) -> thin_owning_dyn_trait<DynTrait, Opt>
+{
+   return thin_owning_dyn_trait<DynTrait, Opt>{std::forward<ToStore>(to_store)};
+}
+
+/// @brief A list of implementations of a trait used to recover concrete types from dyn trait structs
+template<typename... Ts>
+struct impl_list {};
+
+namespace detail {
+
+template<typename T>
+constexpr auto object_as(void* const ptr) noexcept -> T&
+{
+   return *static_cast<T*>(ptr);
+}
+
+template<typename T>
+constexpr auto object_as(const void* const ptr) noexcept -> const T&
+{
+   return *static_cast<const T*>(ptr);
+}
+
+template<typename T, typename Handle>
+using object_ref_t = decltype(object_as<T>(handle_access::data(std::declval<Handle&>())));
+
+// The index of the type h refers to in the list, or the size of the list if it isn't in it
+template<typename... Ts, typename Handle>
+constexpr auto impl_index(impl_list<Ts...>, const Handle& h) noexcept -> std::size_t
+{
+   std::size_t index = 0;
+   static_cast<void>(((handle_access::holds<Ts>(h) || (++index, false)) || ...));
+   return index;
+}
+
+// void is used for types that aren't in the list
+template<typename Ret, typename A, typename B, typename HandleA, typename HandleB, typename Func>
+constexpr auto dispatch2_entry(HandleA& a, HandleB& b, Func& func) -> Ret
+{
+   if constexpr (!std::is_void_v<A> && !std::is_void_v<B>) {
+      if constexpr (std::is_invocable_v<Func&, object_ref_t<A, HandleA>, object_ref_t<B, HandleB>>) {
+         return func(object_as<A>(handle_access::data(a)), object_as<B>(handle_access::data(b)));
+      }
+      else {
+         return func(a, b);
+      }
+   }
+   else {
+      return func(a, b);
+   }
+}
+
+template<typename Ret, typename A, typename HandleA, typename HandleB, typename Func, typename... Bs>
+consteval auto dispatch2_row(impl_list<Bs...>) -> auto
+{
+   return std::array{
+      &dispatch2_entry<Ret, A, Bs, HandleA, HandleB, Func>..., &dispatch2_entry<Ret, A, void, HandleA, HandleB, Func>};
+}
+
+template<typename Ret, typename HandleA, typename HandleB, typename Func, typename... As, typename ImplsB>
+consteval auto dispatch2_table(impl_list<As...>, ImplsB impls_b) -> auto
+{
+   return std::array{
+      dispatch2_row<Ret, As, HandleA, HandleB, Func>(impls_b)...,
+      dispatch2_row<Ret, void, HandleA, HandleB, Func>(impls_b)};
+}
+
+} // namespace detail
+
+/// @brief Calls func with the objects a and b refer to, picking the overload based on both of their types.
+///        If either type isn't in its list or func can't be called with that pair of types,
+///        func is called with a and b themselves instead.
+template<typename ImplsA, typename ImplsB = ImplsA, typename HandleA, typename HandleB, typename Func>
+constexpr auto dispatch2(HandleA& a, HandleB& b, Func&& func) -> decltype(auto)
+{
+   using ret_type = std::invoke_result_t<Func&, HandleA&, HandleB&>;
+   static constexpr auto table
+      = detail::dispatch2_table<ret_type, HandleA, HandleB, std::remove_reference_t<Func>>(ImplsA{}, ImplsB{});
+   return table[detail::impl_index(ImplsA{}, a)][detail::impl_index(ImplsB{}, b)](a, b, func);
+}
+
+namespace detail {
+
+template<typename Ret, typename T, typename... Rest, typename Handle, typename Func>
+constexpr auto visit_impl(Handle& h, Func& func) -> Ret
+{
+   if (handle_access::holds<T>(h)) {
+      return func(object_as<T>(handle_access::data(h)));
+   }
+   if constexpr (sizeof...(Rest) > 0) {
+      return visit_impl<Ret, Rest...>(h, func);
+   }
+   else {
+      return func(h);
+   }
+}
+
+} // namespace detail
+
+/// @brief Calls func with the object h refers to as its concrete type if it is one of Ts,
+///        otherwise calls func with h itself.
+template<typename... Ts, typename Handle, typename Func>
+constexpr auto visit(Handle& h, Func&& func) -> decltype(auto)
+{
+   using ret_type = std::invoke_result_t<Func&, Handle&>;
+   if constexpr (sizeof...(Ts) > 0) {
+      return detail::visit_impl<ret_type, Ts...>(h, func);
+   }
+   else {
+      return static_cast<ret_type>(func(h));
+   }
+}
+
+struct parallel_options {
+   /// @brief The number of handles in each task.
+   ///        If this is 0, a default of 256 is used.
+   std::size_t chunk_size;
+};
+
+/// @brief A pool of threads that claim tasks one at a time until none are left.
+///        The threads are started once and reused by every call to bulk.
+///        The thread calling bulk also runs tasks.  Tasks must not call bulk on the same scheduler, as that
+///        deadlocks.
+struct thread_scheduler {
+   /// @brief Starts thread_count - 1 threads, as the calling thread also runs tasks.
+   ///        If thread_count is 0, std::thread::hardware_concurrency is used.
+   explicit thread_scheduler(const std::size_t thread_count = 0)
+   {
+      const auto num_threads
+         = thread_count != 0 ? thread_count : std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+      workers_.reserve(num_threads - 1);
+      for (std::size_t i = 1; i < num_threads; ++i) {
+         workers_.emplace_back([this](const std::stop_token stop) { work(stop); });
+      }
+   }
+
+   thread_scheduler(const thread_scheduler&) = delete;
+   thread_scheduler& operator=(const thread_scheduler&) = delete;
+
+   ~thread_scheduler()
+   {
+      for (auto& worker : workers_) {
+         worker.request_stop();
+      }
+      work_available_.notify_all();
+   }
+
+   /// @brief If any task throws, tasks that haven't started are skipped and the first exception is rethrown.
+   template<typename Func>
+   auto bulk(const std::size_t task_count, Func&& func) const -> void
+   {
+      if (task_count == 0) {
+         return;
+      }
+      job current{
+         .task_count = task_count,
+         .call = [](void* const f, const std::size_t i) { (*static_cast<std::remove_reference_t<Func>*>(f))(i); },
+         .func = const_cast<void*>(static_cast<const void*>(std::addressof(func))),
+      };
+
+      const std::scoped_lock submit_lock{submit_mutex_};
+      {
+         const std::scoped_lock lock{mutex_};
+         job_ = &current;
+         ++generation_;
+      }
+      work_available_.notify_all();
+      current.run();
+      {
+         std::unique_lock lock{mutex_};
+         job_done_.wait(lock, [&]() { return current.active == 0; });
+         job_ = nullptr;
+      }
+      if (current.error) {
+         std::rethrow_exception(current.error);
+      }
+   }
+
+private:
+   struct job {
+      std::size_t task_count;
+      void (*call)(void*, std::size_t);
+      void* func;
+      std::atomic<std::size_t> next = 0;
+      // The number of pool threads running tasks of this job, guarded by mutex_
+      std::size_t active = 0;
+      std::atomic_flag failed;
+      std::exception_ptr error;
+
+      auto run() noexcept -> void
+      {
+         for (auto i = next.fetch_add(1, std::memory_order_relaxed); i < task_count;
+              i = next.fetch_add(1, std::memory_order_relaxed)) {
+            try {
+               call(func, i);
+            }
+            catch (...) {
+               if (!failed.test_and_set()) {
+                  error = std::current_exception();
+               }
+               next.store(task_count, std::memory_order_relaxed);
+            }
+         }
+      }
+   };
+
+   auto work(const std::stop_token stop) const -> void
+   {
+      std::size_t seen = 0;
+      std::unique_lock lock{mutex_};
+      while (work_available_.wait(lock, stop, [&]() { return generation_ != seen; })) {
+         seen = generation_;
+         auto* const current = job_;
+         if (!current) {
+            continue;
+         }
+         ++current->active;
+         lock.unlock();
+         current->run();
+         lock.lock();
+         if (--current->active == 0) {
+            job_done_.notify_all();
+         }
+      }
+   }
+
+   // Only one job runs at a time
+   mutable std::mutex submit_mutex_;
+   mutable std::mutex mutex_;
+   mutable std::condition_variable_any work_available_;
+   mutable std::condition_variable job_done_;
+   mutable job* job_ = nullptr;
+   mutable std::size_t generation_ = 0;
+   // Declared last so the threads are joined before anything they use is destroyed
+   std::vector<std::jthread> workers_;
+};
+
+/// @brief A scheduler runs func(i) for every i in [0, task_count), possibly concurrently,
+///        and returns once all are done.
+template<typename T>
+concept parallel_scheduler = requires(const T& scheduler) { scheduler.bulk(std::size_t{}, [](std::size_t) {}); };
+
+namespace detail {
+
+// Used by the overloads without a scheduler, so the threads are only started once
+inline auto default_thread_scheduler() -> const thread_scheduler&
+{
+   static const thread_scheduler scheduler{};
+   return scheduler;
+}
+
+// Calls func on every handle in [begin, end) with handles that share a vtable called one after another
+template<typename Range, typename Func>
+auto for_each_grouped(Range& handles, const std::size_t begin, const std::size_t end, Func& func) -> void
+{
+   using handle_type = std::remove_reference_t<std::ranges::range_reference_t<Range>>;
+   // Each thread keeps its buffer between tasks; it's taken for the duration in case func makes a nested call
+   // through a different scheduler (a nested call on the same thread_scheduler deadlocks)
+   thread_local std::vector<handle_type*> buffer;
+   auto group = std::exchange(buffer, {});
+   group.clear();
+   for (auto i = begin; i < end; ++i) {
+      group.push_back(std::addressof(std::ranges::begin(handles)[i]));
+   }
+   std::ranges::sort(group, [](const auto* lhs, const auto* rhs) { return handle_access::vtable_less(*lhs, *rhs); });
+   for (auto* const h : group) {
+      func(*h);
+   }
+   buffer = std::move(group);
+}
+
+} // namespace detail
+
+template<
+   parallel_scheduler Scheduler,
+   std::ranges::random_access_range Range,
+   typename TraitClass,
+   auto... FuncCallerRest,
+   typename... Args>
+   requires std::ranges::sized_range<Range>
+auto parallel_call_each(
+   const Scheduler& scheduler,
+   const parallel_options opt,
+   Range&& handles,
+   const detail::func_caller<TraitClass, FuncCallerRest...> method,
+   const Args&... args) -> void
+{
+   const auto size = std::ranges::size(handles);
+   const auto chunk_size = opt.chunk_size != 0 ? opt.chunk_size : 256;
+   const auto task_count = (size + chunk_size - 1) / chunk_size;
+   auto call = [&](auto& h) { h.call(method, args...); };
+   scheduler.bulk(task_count, [&](const std::size_t task) {
+      detail::for_each_grouped(handles, task * chunk_size, std::min(size, (task + 1) * chunk_size), call);
+   });
+}
+
+template<std::ranges::random_access_range Range, typename TraitClass, auto... FuncCallerRest, typename... Args>
+   requires std::ranges::sized_range<Range>
+auto parallel_call_each(
+   Range&& handles, const detail::func_caller<TraitClass, FuncCallerRest...> method, const Args&... args) -> void
+{
+   parallel_call_each(
+      detail::default_thread_scheduler(), parallel_options{}, std::forward<Range>(handles), method, args...);
+}
+
+/// @brief Calls method on every handle and combines the results with reduce_op.
+///        The order results are combined in is unspecified, so reduce_op must be associative and commutative.
+template<
+   parallel_scheduler Scheduler,
+   std::ranges::random_access_range Range,
+   typename T,
+   typename ReduceOp,
+   typename TraitClass,
+   auto... FuncCallerRest,
+   typename... Args>
+   requires std::ranges::sized_range<Range>
+auto parallel_call_reduce(
+   const Scheduler& scheduler,
+   const parallel_options opt,
+   Range&& handles,
+   T init,
+   ReduceOp reduce_op,
+   const detail::func_caller<TraitClass, FuncCallerRest...> method,
+   const Args&... args) -> T
+{
+   const auto size = std::ranges::size(handles);
+   const auto chunk_size = opt.chunk_size != 0 ? opt.chunk_size : 256;
+   const auto task_count = (size + chunk_size - 1) / chunk_size;
+   std::vector<std::optional<T>> partials(task_count);
+   scheduler.bulk(task_count, [&](const std::size_t task) {
+      auto& partial = partials[task];
+      auto call = [&](auto& h) {
+         if (partial) {
+            partial = reduce_op(std::move(*partial), h.call(method, args...));
+         }
+         else {
+            partial.emplace(h.call(method, args...));
+         }
+      };
+      detail::for_each_grouped(handles, task * chunk_size, std::min(size, (task + 1) * chunk_size), call);
+   });
+   for (auto& partial : partials) {
+      if (partial) {
+         init = reduce_op(std::move(init), std::move(*partial));
+      }
+   }
+   return init;
+}
+
+template<
+   std::ranges::random_access_range Range,
+   typename T,
+   typename ReduceOp,
+   typename TraitClass,
+   auto... FuncCallerRest,
+   typename... Args>
+   requires std::ranges::sized_range<Range>
+auto parallel_call_reduce(
+   Range&& handles,
+   T init,
+   ReduceOp reduce_op,
+   const detail::func_caller<TraitClass, FuncCallerRest...> method,
+   const Args&... args) -> T
+{
+   return parallel_call_reduce(
+      detail::default_thread_scheduler(),
+      parallel_options{},
+      std::forward<Range>(handles),
+      std::move(init),
+      std::move(reduce_op),
+      method,
+      args...);
+}
+
+namespace detail {
+
+// Written before every object in a dyn_ring_buffer.
+// A record with a null funcs only pads out the end of the buffer or covers a failed push and holds no object.
+template<typename Vtable>
+struct ring_record_header {
+   void (*destroy)(void*) noexcept;
+   const Vtable* funcs;
+   // The size of the whole record including this header
+   std::size_t size;
+};
+
+// Calls func when it goes out of scope, including during stack unwinding
+template<typename Func>
+struct on_exit {
+   Func func;
+
+   ~on_exit() { func(); }
+};
+
+} // namespace detail
+
+struct dyn_ring_buffer_options {
+   /// @brief If more than one thread may push at the same time.
+   ///        Producers then reserve space with a compare-and-swap rather than a plain store.
+   bool multi_producer;
+};
+
+/// @brief A single-consumer queue of objects implementing Trait, with one or (optionally) many producers.
+///        Objects are stored inline in a fixed buffer as variable-length records of a small header
+///        followed by the object, so pushing and popping never allocates.
+///        Objects may not be over-aligned.
+template<typename Trait, std::size_t Capacity, dyn_ring_buffer_options Opt = dyn_ring_buffer_options{}>
+   requires(std::has_single_bit(Capacity))
+struct dyn_ring_buffer {
+   using handle_type = non_owning_dyn_trait<Trait>;
+
+   dyn_ring_buffer() = default;
+   dyn_ring_buffer(const dyn_ring_buffer&) = delete;
+   dyn_ring_buffer& operator=(const dyn_ring_buffer&) = delete;
+
+   ~dyn_ring_buffer()
+   {
+      consume_all([](handle_type) {});
+   }
+
+   /// @brief Constructs a copy of obj in the buffer.
+   ///        Returns false without constructing anything if there is not enough free space.
+   ///        Unless Opt.multi_producer is set, only one thread may push at a time.
+   template<typename ToStore>
+      requires(alignof(std::remove_cvref_t<ToStore>) <= alignof(std::max_align_t)
+               && (detail::is_auto_trait<Trait> || detail::is_trait_impl_for<Trait, std::remove_cvref_t<ToStore>>))
+   auto try_push(ToStore&& obj) -> bool
+   {
+      using type = std::remove_cvref_t<ToStore>;
+      static constexpr std::size_t size = header_size + round_up(sizeof(type));
+      static_assert(size <= Capacity, "Object is too large to ever fit in the buffer");
+
+      auto head = head_.load(std::memory_order_relaxed);
+      std::size_t skipped = 0;
+      while (true) {
+         // Records never wrap around; the space until the end of the buffer is skipped instead
+         skipped = Capacity - head % Capacity < size ? Capacity - head % Capacity : 0;
+         if constexpr (Opt.multi_producer) {
+            if (head + skipped + size - tail_.load(std::memory_order_acquire) > Capacity) {
+               // Another producer may have moved head past a tail that has since moved on
+               const auto current = head_.load(std::memory_order_relaxed);
+               if (current == head) {
+                  return false;
+               }
+               head = current;
+            }
+            else if (head_.compare_exchange_weak(head, head + skipped + size, std::memory_order_relaxed)) {
+               break;
+            }
+         }
+         else {
+            if (!has_space(head, skipped + size)) {
+               return false;
+            }
+            head_.store(head + skipped + size, std::memory_order_relaxed);
+            break;
+         }
+      }
+
+      // The space is now reserved, so something has to be committed to it even if constructing obj throws
+      if (skipped != 0) {
+         commit(head, header_type{nullptr, nullptr, skipped});
+      }
+      const auto index = head + skipped;
+      auto* const record = buffer_.data() + index % Capacity;
+      try {
+         new (record + header_size) type{std::forward<ToStore>(obj)};
+      }
+      catch (...) {
+         commit(index, header_type{nullptr, nullptr, size});
+         throw;
+      }
+      commit(
+         index,
+         header_type{
+            detail::deleter_for<type, true>(), &detail::vtable_for<std::remove_const_t<Trait>, type, false>, size});
+      return true;
+   }
+
+   /// @brief Calls func with the oldest object and then destroys it.
+   ///        Returns false if there is no object ready.
+   ///        If func throws, the object is still destroyed and removed from the buffer.
+   ///        Only one thread may consume at a time.
+   template<typename Func>
+   auto try_pop(Func&& func) -> bool
+   {
+      auto tail = tail_.load(std::memory_order_relaxed);
+      const detail::on_exit publish{[&]() noexcept { tail_.store(tail, std::memory_order_release); }};
+      while (committed_at(tail).load(std::memory_order_acquire)) {
+         const auto index = std::exchange(tail, tail + header_at(tail).size);
+         if (header_at(index).funcs) {
+            consume(index, func);
+            return true;
+         }
+         committed_at(index).store(false, std::memory_order_relaxed);
+      }
+      return false;
+   }
+
+   /// @brief Calls func with every object that is ready, oldest first, destroying each one after.
+   ///        The space is handed back to the producers once at the end, rather than once per object.
+   ///        If func throws, the objects up to and including the one it threw for are removed from the buffer.
+   ///        Returns the number of objects consumed.
+   template<typename Func>
+   auto consume_all(Func&& func) -> std::size_t
+   {
+      auto tail = tail_.load(std::memory_order_relaxed);
+      const detail::on_exit publish{[&]() noexcept { tail_.store(tail, std::memory_order_release); }};
+      std::size_t count = 0;
+      while (committed_at(tail).load(std::memory_order_acquire)) {
+         const auto index = std::exchange(tail, tail + header_at(tail).size);
+         if (header_at(index).funcs) {
+            consume(index, func);
+            ++count;
+         }
+         else {
+            committed_at(index).store(false, std::memory_order_relaxed);
+         }
+      }
+      return count;
+   }
+
+private:
+   using header_type = detail::ring_record_header<detail::vtable_type<std::remove_const_t<Trait>>>;
+
+   static constexpr std::size_t record_align = alignof(std::max_align_t);
+
+   static constexpr auto round_up(const std::size_t size) noexcept -> std::size_t
+   {
+      return (size + header_size - 1) / header_size * header_size;
+   }
+
+   // Every record is a multiple of this size, so there is always room for a header before the end of the buffer
+   static constexpr std::size_t header_size = (sizeof(header_type) + record_align - 1) / record_align * record_align;
+
+   static_assert(Capacity % header_size == 0, "Capacity is too small");
+
+   auto has_space(const std::size_t head, const std::size_t needed) noexcept -> bool
+   {
+      if (head + needed - cached_tail_ <= Capacity) {
+         return true;
+      }
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      return head + needed - cached_tail_ <= Capacity;
+   }
+
+   auto header_at(const std::size_t index) noexcept -> header_type&
+   {
+      return *std::launder(static_cast<header_type*>(static_cast<void*>(buffer_.data() + index % Capacity)));
+   }
+
+   // Set by the producer once the record starting at index is written and cleared by the consumer once it's read,
+   // so records are consumed in order even if a later one is committed first
+   auto committed_at(const std::size_t index) noexcept -> std::atomic<bool>&
+   {
+      return committed_[index % Capacity / header_size];
+   }
+
+   auto commit(const std::size_t index, const header_type& header) noexcept -> void
+   {
+      new (buffer_.data() + index % Capacity) header_type{header};
+      committed_at(index).store(true, std::memory_order_release);
+   }
+
+   template<typename Func>
+   auto consume(const std::size_t index, Func& func) -> void
+   {
+      auto& header = header_at(index);
+      void* const obj = static_cast<unsigned char*>(static_cast<void*>(&header)) + header_size;
+      const detail::on_exit cleanup{[&]() noexcept {
+         header.destroy(obj);
+         committed_at(index).store(false, std::memory_order_relaxed);
+      }};
+      func(detail::handle_access::from_parts<handle_type>(obj, *header.funcs));
+   }
+
+   alignas(std::hardware_destructive_interference_size) std::atomic<std::size_t> head_ = 0;
+   // The producer's last view of tail_, to avoid touching the consumer's cache line on every push.
+   // Only used with a single producer.
+   std::size_t cached_tail_ = 0;
+   alignas(std::hardware_destructive_interference_size) std::atomic<std::size_t> tail_ = 0;
+   alignas(std::hardware_destructive_interference_size) std::array<std::atomic<bool>, Capacity / header_size>
+      committed_{};
+   alignas(std::hardware_destructive_interference_size) std::array<unsigned char, Capacity> buffer_;
+};
+
+namespace detail {
+
+consteval auto fnv1a(std::uint64_t hash, const std::string_view str) noexcept -> std::uint64_t
+{
+   for (const auto c : str) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 1099511628211u;
+   }
+   return hash;
+}
+
+template<typename Trait, typename Impl>
+auto create_exported() -> void*
+{
+   auto h = thin_owning_dyn<Trait>(Impl{});
+   return handle_access::release(h);
+}
+
+} // namespace detail
+
+/// @brief A hash of the names of the functions and data members of Trait and the types of its vtable slots.
+///        Type names are as spelled by the compiler, so the hash is only stable for a single compiler.
+template<typename Trait>
+inline constexpr std::uint64_t layout_hash_for = []() consteval {
+   std::uint64_t hash = detail::fnv1a(14695981039346656037u, std::meta::display_string_of(^^Trait));
+   for (const auto f : detail::get_sorted_funcs_by_name(^^Trait)) {
+      hash = detail::fnv1a(hash, std::meta::identifier_of(f));
+   }
+   for (const auto f : detail::get_bulk_funcs(^^Trait)) {
+      hash = detail::fnv1a(hash, std::meta::identifier_of(f));
+   }
+   for (const auto field : detail::get_fields(^^Trait)) {
+      hash = detail::fnv1a(hash, std::meta::identifier_of(field));
+      hash = detail::fnv1a(hash, std::meta::display_string_of(std::meta::type_of(field)));
+   }
+   for (const auto slot : detail::get_members_and_tuple_type(^^Trait, false).second) {
+      hash = detail::fnv1a(hash, std::meta::display_string_of(slot));
+   }
+   return hash;
+}();
+
+/// @brief Describes an implementation of Trait exported from a shared library.
+///        Objects are created and destroyed by the shared library, so they use its allocator,
+///        and calls go straight to the functions in the shared library.
+template<typename Trait>
+struct exported_impl {
+   /// @brief layout_hash_for<Trait> as seen by the shared library.
+   ///        This must stay the first member so it can be checked before anything else is read.
+   std::uint64_t layout_hash;
+   /// @brief Creates a default constructed object, returned as the data of a thin owning dyn trait.
+   void* (*create)();
+
+   auto make() const -> thin_owning_dyn_trait<Trait>
+   {
+      return detail::handle_access::from_parts<thin_owning_dyn_trait<Trait>>(create());
+   }
+};
+
+/// @brief The exported_impl of Impl, meant to be returned from an extern "C" function of a shared library.
+template<typename Trait, std::default_initializable Impl>
+   requires(detail::is_auto_trait<Trait> || detail::is_trait_impl_for<Trait, Impl>)
+inline constexpr exported_impl<Trait> export_impl{.layout_hash = layout_hash_for<Trait>,
+                                                  .create = &detail::create_exported<Trait, Impl>};
+
+/// @brief Checks that exported (the result of export_impl from a shared library) was built with the same layout of
+///        Trait, returning nullptr if it wasn't.
+template<typename Trait>
+auto import_impl(const void* const exported) noexcept -> const exported_impl<Trait>*
+{
+   if (!exported || *static_cast<const std::uint64_t*>(exported) != layout_hash_for<Trait>) {
+      return nullptr;
+   }
+   return static_cast<const exported_impl<Trait>*>(exported);
+}
+
+namespace detail {
+
+template<typename Trait, typename T>
+consteval auto make_impl_entry() noexcept -> impl_entry<Trait>
+{
+   static_assert(std::meta::has_identifier(^^T), "Registered implementations must have a name");
+   return {
+      .name = std::define_static_string(std::meta::identifier_of(^^T)),
+      .size = sizeof(T),
+      .align = alignof(T),
+      .construct = &construct_default<T>,
+      .vtable = &vtable_for<Trait, T, true>,
+   };
+}
+
+} // namespace detail
+
+/// @brief A set of implementations of Trait that can be looked up by name at runtime.
+///        The name is the unqualified name of the type, so it must be unique within the registry.
+///        Owning dyn traits can be constructed directly from the entries, and max_size and max_align
+///        give the storage needed for any of them.
+template<typename Trait, std::default_initializable... Impls>
+   requires(sizeof...(Impls) > 0 && ((detail::is_auto_trait<Trait> || detail::is_trait_impl_for<Trait, Impls>) && ...))
+struct impl_registry {
+   static constexpr std::size_t max_size = std::max({sizeof(Impls)...});
+   static constexpr std::size_t max_align = std::max({alignof(Impls)...});
+
+   /// @brief The entries sorted by name.
+   static constexpr auto entries = []() consteval {
+      std::array entries{detail::make_impl_entry<Trait, Impls>()...};
+      std::ranges::sort(entries, {}, &impl_entry<Trait>::name);
+      if (std::ranges::adjacent_find(entries, {}, &impl_entry<Trait>::name) != entries.end()) {
+         throw "duplicate implementation name";
+      }
+      return entries;
+   }();
+
+   /// @brief Returns the entry with the given name, or nullptr if there isn't one.
+   static constexpr auto find(const std::string_view name) noexcept -> const impl_entry<Trait>*
+   {
+      const auto it = std::ranges::lower_bound(entries, name, {}, &impl_entry<Trait>::name);
+      return it != entries.end() && it->name == name ? std::to_address(it) : nullptr;
+   }
+};
+
+/// @brief The address of a function stored in a vtable and a readable name for it.
+struct vtable_symbol {
+   const void* address;
+   std::string_view name;
+};
+
+struct vtable_symbols_options {
+   /// @brief If the destructors of thin owning dyn traits should be listed.
+   ///        Naming them requires them to be generated, so only set this if thin owning dyn traits are used.
+   bool include_thin_destructors;
+};
+
+namespace detail {
+
+consteval auto symbol_name(std::meta::info trait, std::meta::info f, std::meta::info impl, std::string_view suffix)
+   -> const char*
+{
+   std::string name{std::meta::display_string_of(trait)};
+   name += "::";
+   name += std::meta::identifier_of(f);
+   name += suffix;
+   name += " for ";
+   name += std::meta::display_string_of(impl);
+   return std::define_static_string(name);
+}
+
+consteval auto destructor_symbol_name(std::meta::info impl, std::string_view suffix) -> const char*
+{
+   std::string name{std::meta::display_string_of(impl)};
+   name += " destructor";
+   name += suffix;
+   return std::define_static_string(name);
+}
+
+// The names of the functions in the vtable slots of Impl for Trait, in slot order.
+// Direct slots are null, since they point at functions that already have readable names
+// (and static default implementations are shared by every implementation).
+consteval auto slot_symbol_names(std::meta::info trait, std::meta::info impl) -> std::vector<const char*>
+{
+   std::vector<const char*> names;
+   for (const auto f : get_sorted_funcs_by_name(trait)) {
+      // Thunks shared through a base are named after the base
+      const auto impl_func = find_impl_func(impl, f);
+      const auto owner = impl_func != std::meta::info{} ? thunk_class(impl_func, impl) : impl;
+      names.push_back(is_direct_slot(f) ? nullptr : symbol_name(trait, f, owner, ""));
+   }
+   for (const auto f : get_bulk_funcs(trait)) {
+      names.push_back(symbol_name(trait, f, impl, " (bulk)"));
+   }
+   return names;
+}
+
+template<typename Trait, vtable_symbols_options Opt, typename Impl>
+auto append_vtable_symbols(std::vector<vtable_symbol>& symbols) -> void
+{
+   static constexpr auto names = std::define_static_array(slot_symbol_names(^^Trait, ^^Impl));
+   static constexpr const auto& funcs = vtable_for<Trait, Impl, false>;
+   [&]<std::size_t... Is>(std::index_sequence<Is...>) {
+      ((names[Is] ? symbols.push_back({reinterpret_cast<const void*>(funcs.template get<Is>()), names[Is]})
+                  : void()),
+       ...);
+   }(std::make_index_sequence<names.size()>{});
+
+   if constexpr (!std::is_trivially_destructible_v<Impl>) {
+      static constexpr auto destructor_name = destructor_symbol_name(^^Impl, "");
+      symbols.push_back({reinterpret_cast<const void*>(&destroy_object<Impl>), destructor_name});
+   }
+   // Thin owning dyn traits have their own destructors, which also free the heap block
+   if constexpr (Opt.include_thin_destructors) {
+      static constexpr auto thin_destructor_name = destructor_symbol_name(^^Impl, " (thin owning dyn trait)");
+      static constexpr auto thin_inline_destructor_name
+         = destructor_symbol_name(^^Impl, " (thin owning dyn trait with an inline vtable)");
+      symbols.push_back(
+         {reinterpret_cast<const void*>(&destroy_thin<Impl, thin_header_type<Trait, false>>), thin_destructor_name});
+      symbols.push_back(
+         {reinterpret_cast<const void*>(&destroy_thin<Impl, thin_header_type<Trait, true>>),
+          thin_inline_destructor_name});
+   }
+}
+
+} // namespace detail
+
+/// @brief Readable names ("Trait::function for Impl") for the functions stored in the vtables of Impls for Trait.
+///        Most of these are generated thunks, which otherwise only have the mangled names of lambdas;
+///        profiler output can be made readable by renaming the functions that start at these addresses.
+///        Slots that point straight at a static function are left out, as those already have readable names.
+///        The result is sorted by address with one entry per address; if the linker folded identical functions
+///        together, only one of their names is kept.
+template<typename Trait, vtable_symbols_options Opt = {}, typename... Impls>
+auto vtable_symbols(impl_list<Impls...>) -> std::vector<vtable_symbol>
+{
+   std::vector<vtable_symbol> symbols;
+   (detail::append_vtable_symbols<Trait, Opt, Impls>(symbols), ...);
+   std::ranges::sort(symbols, std::less<>{}, &vtable_symbol::address);
+   const auto duplicates = std::ranges::unique(symbols, {}, &vtable_symbol::address);
+   symbols.erase(duplicates.begin(), duplicates.end());
+   return symbols;
+}
+
+/// @brief Writes a line of "<hex address> <name>" for each symbol to file.
+///        Addresses are as loaded in this process, so they are only meaningful together with its memory map.
+inline auto write_symbol_map(std::FILE* const file, const std::span<const vtable_symbol> symbols) -> void
+{
+   for (const auto& symbol : symbols) {
+      std::fprintf(
+         file,
+         "%zx %.*s\n",
+         static_cast<std::size_t>(reinterpret_cast<std::uintptr_t>(symbol.address)),
+         static_cast<int>(symbol.name.size()),
+         symbol.name.data());
+   }
+}
+
+/// @brief A source of values of type T that are produced a batch at a time.
+template<typename T>
+struct[[= auto_trait]] batch_source {
+   /// @brief Writes up to out.size() values to the start of out and returns how many were written.
+   ///        Returns 0 once there are no more values.
+   std::size_t next_batch(std::span<T> out);
+};
+
+namespace detail {
+
+template<typename T, typename Range>
+struct range_batch_source {
+   Range range;
+   // Created on first use, once the source is at its final address
+   std::optional<std::ranges::iterator_t<Range>> it;
+
+   auto next_batch(std::span<T> out) -> std::size_t
+   {
+      if (!it) {
+         it.emplace(std::ranges::begin(range));
+      }
+      std::size_t count = 0;
+      for (; count < out.size() && *it != std::ranges::end(range); ++*it, ++count) {
+         out[count] = **it;
+      }
+      return count;
+   }
+};
+
+} // namespace detail
+
+/// @brief A type erased input range of T.
+///        Values are pulled from the underlying range BatchSize at a time with a single call through the vtable,
+///        and iterating over the buffered values makes no indirect calls.
+template<std::default_initializable T, std::size_t BatchSize = 64>
+   requires(BatchSize > 0)
+struct dyn_range {
+   using source_type = owning_dyn_trait<batch_source<T>>;
+
+   struct iterator {
+      using value_type = T;
+      using difference_type = std::ptrdiff_t;
+
+      auto operator*() const noexcept -> T& { return range_->buffer_[pos_]; }
+
+      auto operator++() -> iterator&
+      {
+         if (++pos_ == range_->size_) {
+            range_->refill();
+            pos_ = 0;
+         }
+         return *this;
+      }
+
+      auto operator++(int) -> void { ++*this; }
+
+      friend auto operator==(const iterator& it, std::default_sentinel_t) noexcept -> bool
+      {
+         return it.range_->size_ == 0;
+      }
+
+   private:
+      friend struct dyn_range;
+
+      explicit iterator(dyn_range* const range) noexcept : range_{range} {}
+
+      dyn_range* range_;
+      std::size_t pos_ = 0;
+   };
+
+   explicit dyn_range(source_type source) : source_{std::move(source)} {}
+
+   template<std::ranges::input_range Range>
+      requires(!std::is_same_v<std::remove_cvref_t<Range>, dyn_range>
+               && std::is_assignable_v<T&, std::ranges::range_reference_t<Range>>)
+   explicit dyn_range(Range&& range)
+      : source_{owning_dyn<batch_source<T>>(
+           detail::range_batch_source<T, std::views::all_t<Range>>{std::views::all(std::forward<Range>(range)), {}})}
+   {}
+
+   dyn_range(const dyn_range&) = delete;
+   dyn_range& operator=(const dyn_range&) = delete;
+   dyn_range(dyn_range&&) = default;
+   dyn_range& operator=(dyn_range&&) = default;
+
+   /// @brief Reads the next batch of values, which invalidates iterators from before.
+   ///        As with other input ranges, this may only be called once.
+   auto begin() -> iterator
+   {
+      refill();
+      return iterator{this};
+   }
+
+   auto end() const noexcept -> std::default_sentinel_t { return std::default_sentinel; }
+
+   /// @brief Pulls the next values directly into out, bypassing the internal buffer.
+   auto next_batch(const std::span<T> out) -> std::size_t { return source_.call(source_.next_batch, out); }
+
+private:
+   auto refill() -> void { size_ = next_batch(buffer_); }
+
+   source_type source_;
+   std::array<T, BatchSize> buffer_{};
+   std::size_t size_ = 0;
+};
+
 } // namespace khct
 
 #endif // CPP_DYN_HPP
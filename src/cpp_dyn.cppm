@@ -7,14 +7,43 @@ export module khct.cpp_dyn;
 export namespace khct {
 
 using khct::auto_trait;
+using khct::batch_source;
+using khct::bulk;
 using khct::default_impl;
+using khct::dispatch2;
 using khct::dyn;
+using khct::dyn_range;
+using khct::dyn_ring_buffer;
+using khct::dyn_ring_buffer_options;
+using khct::export_impl;
+using khct::exported_impl;
+using khct::impl_entry;
 using khct::impl_for;
+using khct::impl_list;
+using khct::impl_registry;
+using khct::import_impl;
+using khct::layout_hash_for;
 using khct::non_owning_dyn_options;
 using khct::non_owning_dyn_trait;
 using khct::owning_dyn;
 using khct::owning_dyn_options;
 using khct::owning_dyn_trait;
+using khct::parallel_call_each;
+using khct::parallel_call_reduce;
+using khct::parallel_options;
+using khct::parallel_scheduler;
+using khct::static_dyn;
+using khct::thin_owning_dyn;
+using khct::thin_owning_dyn_options;
+using khct::thin_owning_dyn_trait;
+using khct::thread_scheduler;
 using khct::trait;
+using khct::visit;
+using khct::vtable_stats;
+using khct::vtable_stats_for;
+using khct::vtable_symbol;
+using khct::vtable_symbols;
+using khct::vtable_symbols_options;
+using khct::write_symbol_map;
 
 } // namespace khct
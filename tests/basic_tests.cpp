@@ -4,6 +4,9 @@
 #include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 
+#include <numeric>
+#include <stdexcept>
+
 TEST_CASE("Basic functionality", "[basic]")
 {
    const auto trait = khct::owning_dyn<noise_trait, khct::owning_dyn_options{.stack_size = 8}>(cow{});
@@ -56,4 +59,361 @@ TEST_CASE("Examples", "[example]")
    my_struct s;
    REQUIRE(take_interface(khct::dyn<my_interface>(&s)) == 20);
    REQUIRE(take_interface2(khct::owning_dyn<my_interface>(s)) == 40);
+
+   // The stored copy of a const object can still be modified
+   const my_struct const_s;
+   auto trait = khct::owning_dyn<my_interface>(const_s);
+   trait.call(trait.set_data, 5);
+   REQUIRE(trait.call(trait.get_data) == 5);
+
+   const cow const_cow{};
+   khct::owning_dyn_trait<noise_trait> trait2{const_cow};
+   trait2.call(trait2.get_louder);
+   REQUIRE(trait2.call(trait2.volume) == 2);
+   REQUIRE(const_cow.volume_ == 1);
+}
+
+TEST_CASE("Parallel calls", "[parallel]")
+{
+   std::vector<khct::owning_dyn_trait<noise_trait>> animals;
+   for (int i = 0; i < 1000; ++i) {
+      if (i % 3 == 0) {
+         animals.push_back(khct::owning_dyn<noise_trait>(dog{}));
+      }
+      else {
+         animals.push_back(khct::owning_dyn<noise_trait>(cow{}));
+      }
+   }
+
+   const auto& first = animals.front();
+   const khct::thread_scheduler scheduler{4};
+   khct::parallel_call_each(scheduler, {.chunk_size = 16}, animals, first.get_louder);
+   // The same threads are reused
+   khct::parallel_call_each(scheduler, {.chunk_size = 16}, animals, first.get_louder);
+   // Cows go from 1 to 3 and dogs go from 9 to 36
+   const auto total = khct::parallel_call_reduce(animals, 0, std::plus<>{}, first.volume, 1);
+   REQUIRE(total == 666 * 3 + 334 * 36);
+
+   const auto fail_one = [](const std::size_t i) {
+      if (i == 50) {
+         throw std::runtime_error{"task failed"};
+      }
+   };
+   REQUIRE_THROWS_AS(scheduler.bulk(100, fail_one), std::runtime_error);
+}
+
+struct[[= khct::auto_trait]] prioritized {
+   int id;
+   int priority;
+   int weight() const noexcept;
+};
+
+struct job {
+   std::string name;
+   int priority;
+   int id;
+   int weight() const noexcept { return priority * 10; }
+};
+
+using job_id = int;
+
+struct[[= khct::auto_trait]] identified {
+   job_id id;
+};
+
+TEST_CASE("Data members", "[data_member]")
+{
+   job j{"build", 3, 7};
+   auto trait = khct::dyn<prioritized>(&j);
+   REQUIRE(trait.get(trait.id) == 7);
+   trait.get(trait.priority) = 5;
+   REQUIRE(j.priority == 5);
+   REQUIRE(trait.call(trait.weight) == 50);
+
+   // Aliases of the same type match
+   const auto id_trait = khct::dyn<const identified>(&j);
+   REQUIRE(id_trait.get(id_trait.id) == 7);
+   REQUIRE(!khct::default_non_owning_opt_for<prioritized>.store_vtable_inline);
+
+   const auto trait2 = khct::owning_dyn<prioritized>(j);
+   REQUIRE(trait2.get(trait2.id) == 7);
+   REQUIRE(trait2.get(trait2.priority) == 5);
+}
+
+TEST_CASE("Thin owning dyn traits", "[thin]")
+{
+   auto trait = khct::thin_owning_dyn<my_interface>(my_struct{});
+   trait.call(trait.set_data, 5);
+   REQUIRE(trait.call(trait.get_data) == 5);
+   auto trait2 = std::move(trait);
+   REQUIRE(trait2.call(trait2.get_data) == 5);
+
+   auto trait3 = khct::thin_owning_dyn<noise_trait, khct::thin_owning_dyn_options{.store_vtable_inline = true}>(dog{});
+   trait3.call(trait3.get_louder_twice);
+   REQUIRE(trait3.call(trait3.volume) == 36);
+   REQUIRE(trait3.call(trait3.get_secondary_noise) == "bark");
+   trait3 = khct::thin_owning_dyn<noise_trait, khct::thin_owning_dyn_options{.store_vtable_inline = true}>(cow{});
+   REQUIRE(trait3.call(trait3.get_noise) == "moo");
+}
+
+struct[[= khct::impl_for<my_interface>]] padded_struct {
+   int get_data() const noexcept { return data_[0]; }
+   void set_data(int new_data) noexcept { data_[0] = new_data; }
+
+private:
+   std::array<int, 16> data_{};
+};
+
+TEST_CASE("Ring buffers", "[ring]")
+{
+   khct::dyn_ring_buffer<my_interface, 256> buffer;
+   std::vector<int> seen;
+   const auto record = [&](auto obj) { seen.push_back(obj.call(obj.get_data)); };
+
+   padded_struct s;
+   for (int i = 1; i <= 3; ++i) {
+      s.set_data(i);
+      REQUIRE(buffer.try_push(s) == (i != 3));
+   }
+   REQUIRE(buffer.try_pop(record));
+   // This one doesn't fit before the end of the buffer, so it goes at the start
+   REQUIRE(buffer.try_push(s));
+   REQUIRE(buffer.consume_all(record) == 2);
+   REQUIRE(seen == std::vector{1, 2, 3});
+   REQUIRE(!buffer.try_pop(record));
+
+   khct::dyn_ring_buffer<my_interface, 1024> shared;
+   constexpr int count = 100'000;
+   std::jthread producer{[&]() {
+      for (int i = 0; i < count; ++i) {
+         my_struct obj;
+         obj.set_data(i);
+         while (!shared.try_push(obj)) {}
+      }
+   }};
+   long long total = 0;
+   int received = 0;
+   while (received < count) {
+      received += static_cast<int>(shared.consume_all([&](auto obj) { total += obj.call(obj.get_data); }));
+   }
+   REQUIRE(total == static_cast<long long>(count) * (count - 1) / 2);
+
+   khct::dyn_ring_buffer<my_interface, 1024, khct::dyn_ring_buffer_options{.multi_producer = true}> multi;
+   constexpr int producer_count = 4;
+   {
+      std::vector<std::jthread> producers;
+      for (int p = 0; p < producer_count; ++p) {
+         producers.emplace_back([&]() {
+            for (int i = 0; i < count; ++i) {
+               my_struct obj;
+               obj.set_data(i);
+               while (!multi.try_push(obj)) {}
+            }
+         });
+      }
+      total = 0;
+      received = 0;
+      while (received < count * producer_count) {
+         received += static_cast<int>(multi.consume_all([&](auto obj) { total += obj.call(obj.get_data); }));
+      }
+   }
+   REQUIRE(total == static_cast<long long>(count) * (count - 1) / 2 * producer_count);
+}
+
+struct[[= khct::impl_for<my_interface>]] live_counted {
+   static inline int live = 0;
+
+   live_counted() noexcept { ++live; }
+   live_counted(const live_counted& other) noexcept : data_{other.data_} { ++live; }
+   ~live_counted() { --live; }
+
+   int get_data() const noexcept { return data_; }
+   void set_data(int new_data) noexcept { data_ = new_data; }
+
+private:
+   int data_ = 0;
+};
+
+TEST_CASE("Ring buffers with a throwing consumer", "[ring]")
+{
+   {
+      khct::dyn_ring_buffer<my_interface, 256> buffer;
+      for (int i = 0; i < 3; ++i) {
+         live_counted obj;
+         obj.set_data(i);
+         REQUIRE(buffer.try_push(obj));
+      }
+      REQUIRE(live_counted::live == 3);
+
+      const auto fail_on_one = [](auto obj) {
+         if (obj.call(obj.get_data) == 1) {
+            throw std::runtime_error{"bad message"};
+         }
+      };
+      REQUIRE_THROWS_AS(buffer.consume_all(fail_on_one), std::runtime_error);
+      // The object that threw is removed along with the ones before it
+      REQUIRE(live_counted::live == 1);
+      REQUIRE(buffer.consume_all([](auto) {}) == 1);
+      REQUIRE(live_counted::live == 0);
+
+      live_counted obj;
+      obj.set_data(1);
+      REQUIRE(buffer.try_push(obj));
+      REQUIRE_THROWS_AS(buffer.try_pop(fail_on_one), std::runtime_error);
+      REQUIRE(live_counted::live == 1);
+      REQUIRE(!buffer.try_pop([](auto) {}));
+   }
+   REQUIRE(live_counted::live == 0);
+}
+
+struct countdown {
+   int next;
+
+   std::size_t next_batch(std::span<int> out) noexcept
+   {
+      std::size_t count = 0;
+      for (; count < out.size() && next > 0; ++count) {
+         out[count] = next--;
+      }
+      return count;
+   }
+};
+
+TEST_CASE("Dyn ranges", "[range]")
+{
+   std::vector<int> values(100);
+   std::ranges::iota(values, 0);
+   std::vector<int> result;
+   for (const auto value : khct::dyn_range<int, 16>{values | std::views::filter([](int i) { return i % 2 == 0; })}) {
+      result.push_back(value);
+   }
+   REQUIRE(result.size() == 50);
+   REQUIRE(result.back() == 98);
+
+   int total = 0;
+   for (const auto value : khct::dyn_range<int>{khct::owning_dyn<khct::batch_source<int>>(countdown{100})}) {
+      total += value;
+   }
+   REQUIRE(total == 5050);
+
+   khct::dyn_range<int, 8> empty{std::vector<int>{}};
+   REQUIRE(empty.begin() == empty.end());
+}
+
+TEST_CASE("Exported implementations", "[plugin]")
+{
+   // Normally this would come from dlsym
+   const void* const exported = &khct::export_impl<my_interface, my_struct>;
+   const auto* const impl = khct::import_impl<my_interface>(exported);
+   REQUIRE(impl != nullptr);
+   auto trait = impl->make();
+   REQUIRE(trait.call(trait.get_data) == 1);
+   trait.call(trait.set_data, 8);
+   REQUIRE(trait.call(trait.get_data) == 8);
+
+   REQUIRE(khct::import_impl<noise_trait>(exported) == nullptr);
+}
+
+TEST_CASE("Vtable symbols", "[symbols]")
+{
+   const auto symbols = khct::vtable_symbols<my_interface>(khct::impl_list<my_struct, padded_struct>{});
+   REQUIRE(std::ranges::is_sorted(symbols, std::less<>{}, &khct::vtable_symbol::address));
+   // Identical functions may have been folded together, keeping only one of their names, so only check that
+   // every function has a name rather than counting them
+   for (const auto name : {"my_interface::get_data for ", "my_interface::set_data for ", "my_struct destructor"}) {
+      REQUIRE(std::ranges::any_of(symbols, [&](const khct::vtable_symbol& symbol) {
+         return symbol.name.contains(name);
+      }));
+   }
+   // Thin owning destructors are only listed when asked for
+   REQUIRE(std::ranges::none_of(symbols, [](const khct::vtable_symbol& symbol) {
+      return symbol.name.contains("thin owning");
+   }));
+   const auto thin_symbols
+      = khct::vtable_symbols<my_interface, khct::vtable_symbols_options{.include_thin_destructors = true}>(
+         khct::impl_list<my_struct>{});
+   REQUIRE(std::ranges::any_of(thin_symbols, [](const khct::vtable_symbol& symbol) {
+      return symbol.name.contains("thin owning") && symbol.name.contains("my_struct");
+   }));
+
+   // Static functions are stored directly, so they have no generated function to name
+   const auto noise_symbols = khct::vtable_symbols<noise_trait>(khct::impl_list<cow, dog>{});
+   REQUIRE(std::ranges::none_of(noise_symbols, [](const khct::vtable_symbol& symbol) {
+      return symbol.name.contains("get_noise") || symbol.name.contains("get_secondary_noise");
+   }));
+   REQUIRE(std::ranges::adjacent_find(noise_symbols, {}, &khct::vtable_symbol::address) == noise_symbols.end());
+}
+
+struct[[= khct::auto_trait]] counter {
+   int count() const noexcept;
+};
+
+struct counter_base {
+   int count() const noexcept { return count_; }
+
+   int count_ = 3;
+};
+
+struct tally : counter_base {};
+
+struct ticker : counter_base {};
+
+TEST_CASE("Inherited implementations", "[inherited]")
+{
+   const tally t{};
+   const ticker k{};
+   const auto tally_trait = khct::dyn<const counter>(&t);
+   const auto ticker_trait = khct::dyn<const counter>(&k);
+   REQUIRE(tally_trait.call(tally_trait.count) == 3);
+   REQUIRE(ticker_trait.call(ticker_trait.count) == 3);
+
+   // Both call count through counter_base, so they share one thunk
+   const auto symbols = khct::vtable_symbols<counter>(khct::impl_list<tally, ticker>{});
+   REQUIRE(std::ranges::count_if(symbols, [](const khct::vtable_symbol& symbol) {
+              return symbol.name.starts_with("counter::count");
+           })
+           == 1);
+   REQUIRE(std::ranges::any_of(symbols, [](const khct::vtable_symbol& symbol) {
+      return symbol.name.starts_with("counter::count") && symbol.name.ends_with("counter_base");
+   }));
+}
+
+struct alignas(64) aligned_animal {
+   static constexpr std::string_view get_noise() noexcept { return "hum"; }
+   constexpr int volume(int multiplier) const noexcept { return multiplier; }
+   constexpr void get_louder() noexcept {}
+};
+
+TEST_CASE("Impl registries", "[registry]")
+{
+   using animals = khct::impl_registry<noise_trait, cow, dog>;
+   static_assert(animals::max_size == sizeof(int));
+   REQUIRE(animals::find("cat") == nullptr);
+   const auto* const entry = animals::find("dog");
+   REQUIRE(entry != nullptr);
+
+   khct::owning_dyn_trait<noise_trait, khct::owning_dyn_options{.stack_size = animals::max_size}> trait{*entry};
+   REQUIRE(trait.call(trait.get_noise) == "arf");
+   trait.call(trait.get_louder);
+   REQUIRE(trait.call(trait.volume) == 18);
+
+   // Entries that don't fit in the storage are rejected
+   using too_small = khct::owning_dyn_trait<noise_trait, khct::owning_dyn_options{.stack_size = 1}>;
+   REQUIRE_THROWS_AS(too_small{*entry}, std::invalid_argument);
+
+   // As are entries that are more aligned than the storage, whether it's on the heap or the stack
+   using aligned = khct::impl_registry<noise_trait, aligned_animal>;
+   static_assert(aligned::max_align == 64);
+   const auto* const aligned_entry = aligned::find("aligned_animal");
+   REQUIRE(aligned_entry != nullptr);
+   REQUIRE_THROWS_AS(khct::owning_dyn_trait<noise_trait>{*aligned_entry}, std::invalid_argument);
+   using unaligned_stack = khct::owning_dyn_trait<noise_trait, khct::owning_dyn_options{.stack_size = 64}>;
+   REQUIRE_THROWS_AS(unaligned_stack{*aligned_entry}, std::invalid_argument);
+   using aligned_stack
+      = khct::owning_dyn_trait<noise_trait, khct::owning_dyn_options{.stack_size = 64, .stack_align = 64}>;
+   const aligned_stack aligned_trait{*aligned_entry};
+   REQUIRE(aligned_trait.call(aligned_trait.get_noise) == "hum");
+
+   khct::owning_dyn_trait<my_interface> trait2{std::in_place_type<my_struct>};
+   REQUIRE(trait2.call(trait2.get_data) == 1);
 }
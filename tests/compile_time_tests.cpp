@@ -2,6 +2,7 @@
 #include "test_common.hpp"
 
 #include <cassert>
+#include <span>
 
 static constexpr cow c{};
 static constexpr dog d{};
@@ -22,6 +23,24 @@ static_assert(owner2.call(owner2.get_secondary_noise) == "bark");
 // One pointer to the data, 6 pointers to methods
 static_assert(sizeof(owner2) == sizeof(void*) + sizeof(void*) * 6);
 
+// A thin owning dyn trait is just a pointer to the object
+static_assert(sizeof(khct::thin_owning_dyn_trait<noise_trait>) == sizeof(void*));
+static_assert(
+   sizeof(khct::thin_owning_dyn_trait<noise_trait, khct::thin_owning_dyn_options{.store_vtable_inline = true}>)
+   == sizeof(void*));
+
+// Local storage is aligned as requested, so over-aligned objects can be stored in it
+static_assert(
+   alignof(khct::owning_dyn_trait<noise_trait, khct::owning_dyn_options{.stack_size = 64, .stack_align = 64}>) == 64);
+
+// Static functions are stored directly in the vtable, everything else goes through a thunk
+static_assert(khct::vtable_stats_for<noise_trait>.slot_count == 6);
+static_assert(khct::vtable_stats_for<noise_trait>.direct_slot_count == 2);
+static_assert(khct::vtable_stats_for<noise_trait>.thunk_slot_count == 4);
+static_assert(khct::vtable_stats_for<noise_trait>.owning_vtable_size == sizeof(void*) * 7);
+static_assert(owner2.call(owner2.get_noise) == "arf");
+static_assert(noexcept(owner2.call(owner2.get_secondary_noise)));
+
 consteval
 {
    cow cow2{};
@@ -34,6 +53,148 @@ consteval
    assert(trait2.call(trait.volume, 1) == 4);
 }
 
+struct[[= khct::auto_trait]] pricing_model {
+   [[= khct::bulk]] int price(int quantity) const noexcept;
+};
+
+struct flat_rate {
+   constexpr int price(int quantity) const noexcept { return rate_ * quantity; }
+
+   int rate_;
+};
+
+struct discounted_rate {
+   constexpr int price(int quantity) const noexcept { return rate_ * quantity - 1; }
+
+   static constexpr void
+      price(std::span<const discounted_rate> objs, std::span<int> out, std::span<const int> quantities) noexcept
+   {
+      for (std::size_t i = 0; i < objs.size(); ++i) {
+         out[i] = objs[i].rate_ * quantities[i] - 2;
+      }
+   }
+
+   int rate_;
+};
+
+consteval
+{
+   const int quantities[]{1, 2, 3};
+   int out[3]{};
+
+   // No batch version, so this loops over price
+   const flat_rate flat[]{{1}, {2}, {3}};
+   const auto flat_trait = khct::dyn<const pricing_model>(&flat[0]);
+   flat_trait.call_bulk(flat_trait.price, 3, std::span<int>{out}, std::span<const int>{quantities});
+   assert(out[0] == 1 && out[1] == 4 && out[2] == 9);
+
+   // Uses the batch version (which differs from price so that it can be detected)
+   const discounted_rate discounted[]{{1}, {2}, {3}};
+   const auto discounted_trait = khct::dyn<const pricing_model>(&discounted[0]);
+   assert(discounted_trait.call(discounted_trait.price, 2) == 1);
+   discounted_trait.call_bulk(discounted_trait.price, 3, std::span<int>{out}, std::span<const int>{quantities});
+   assert(out[0] == -1 && out[1] == 2 && out[2] == 7);
+}
+
+// A function and its bulk slot is two slots, which is too many to store inline by default
+static_assert(!khct::default_non_owning_opt_for<pricing_model>.store_vtable_inline);
+static_assert(sizeof(khct::non_owning_dyn_trait<const pricing_model>) == sizeof(void*) * 2);
+
+struct[[= khct::auto_trait]] shape {
+   int sides() const noexcept;
+};
+
+struct square {
+   constexpr int sides() const noexcept { return 4; }
+};
+
+struct triangle {
+   constexpr int sides() const noexcept { return 3; }
+};
+
+struct circle {
+   constexpr int sides() const noexcept { return 0; }
+};
+
+struct collider {
+   constexpr int operator()(const square&, const square&) const noexcept { return 1; }
+   constexpr int operator()(const square&, const triangle&) const noexcept { return 2; }
+   constexpr int
+      operator()(khct::non_owning_dyn_trait<const shape>, khct::non_owning_dyn_trait<const shape>) const noexcept
+   {
+      return -1;
+   }
+};
+
+consteval
+{
+   const square s{};
+   const triangle t{};
+   const circle c{};
+   const auto square_trait = khct::dyn<const shape>(&s);
+   const auto triangle_trait = khct::dyn<const shape>(&t);
+   const auto circle_trait = khct::dyn<const shape>(&c);
+
+   using impls = khct::impl_list<square, triangle>;
+   assert(khct::dispatch2<impls>(square_trait, square_trait, collider{}) == 1);
+   assert(khct::dispatch2<impls>(square_trait, triangle_trait, collider{}) == 2);
+   // No overload for this pair
+   assert(khct::dispatch2<impls>(triangle_trait, square_trait, collider{}) == -1);
+   // circle isn't in the list
+   assert(khct::dispatch2<impls>(square_trait, circle_trait, collider{}) == -1);
+}
+
+// The same code can be used with static and dynamic dispatch
+constexpr int louder_volume(auto animal) noexcept
+{
+   animal.call(animal.get_louder_twice);
+   return animal.call(animal.volume);
+}
+
+static_assert(sizeof(khct::static_dyn<noise_trait, cow>) == sizeof(void*));
+
+consteval
+{
+   cow cow2{};
+   dog dog2{};
+   assert(louder_volume(khct::static_dyn<noise_trait, cow>{&cow2}) == 3);
+   assert(louder_volume(khct::dyn<noise_trait>(&cow2)) == 5);
+   assert(louder_volume(khct::static_dyn<noise_trait, dog>{&dog2}) == 36);
+
+   const auto trait = khct::static_dyn<const noise_trait, dog>{&dog2};
+   assert(trait.call(trait.get_secondary_noise) == "bark");
+   assert(trait.call(trait.volume, 2) == 72);
+
+   // Calls go straight to the implementation, so they are noexcept if it is, even when the trait function isn't
+   auto static_trait = khct::static_dyn<noise_trait, cow>{&cow2};
+   auto dyn_trait = khct::dyn<noise_trait>(&cow2);
+   static_assert(noexcept(static_trait.call(static_trait.get_louder)));
+   static_assert(!noexcept(dyn_trait.call(dyn_trait.get_louder)));
+   static_trait.call(static_trait.get_louder);
+   assert(static_trait.call(static_trait.volume) == 6);
+}
+
+// Traits with different slots have different layout hashes
+static_assert(khct::layout_hash_for<noise_trait> != khct::layout_hash_for<shape>);
+
+struct sides_visitor {
+   constexpr int operator()(const square& s) const noexcept { return s.sides() * 10; }
+   constexpr int operator()(const triangle& t) const noexcept { return t.sides() * 10; }
+   constexpr int operator()(khct::non_owning_dyn_trait<const shape> h) const noexcept { return h.call(h.sides); }
+};
+
+consteval
+{
+   const square s{};
+   const circle c{};
+   const auto square_trait = khct::dyn<const shape>(&s);
+   const auto circle_trait = khct::dyn<const shape>(&c);
+
+   assert((khct::visit<square, triangle>(square_trait, sides_visitor{}) == 40));
+   // circle isn't listed, so this goes through the vtable
+   assert((khct::visit<square, triangle>(circle_trait, sides_visitor{}) == 0));
+}
+
 // Verify some traits (these checking traits are missing right now)
 // static_assert(std::is_trivially_relocatable_v<khct::non_owning_dyn_trait<noise_trait>> &&
 // std::is_replacable_v<khct::non_owning_dyn_trait<noise_trait>>);